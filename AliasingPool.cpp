@@ -0,0 +1,192 @@
+#include <VulkanWrappers/AliasingPool.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/DescriptorHeap.h>
+
+#include <algorithm>
+
+using namespace VulkanWrappers;
+
+AliasingPool::AliasingPool(Device* device)
+    : m_Device(device), m_SupportsLazyAllocation(false), m_AllocatedSize(0), m_RequestedSize(0)
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties = {};
+    vkGetPhysicalDeviceMemoryProperties(device->GetPhysical(), &memoryProperties);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+            m_SupportsLazyAllocation = true;
+    }
+}
+
+AliasingPool::~AliasingPool()
+{
+    Release();
+}
+
+uint32_t AliasingPool::Add(Image* image, uint32_t firstUse, uint32_t lastUse)
+{
+    Entry entry = {};
+    entry.image    = image;
+    entry.firstUse = firstUse;
+    entry.lastUse  = lastUse;
+    entry.slot     = UINT32_MAX;
+
+    m_Entries.push_back(entry);
+
+    return (uint32_t)m_Entries.size() - 1;
+}
+
+void AliasingPool::Build()
+{
+    std::vector<uint32_t> order;
+
+    for (uint32_t i = 0; i < m_Entries.size(); ++i)
+    {
+        auto& entry = m_Entries[i];
+
+        // Requirements straight from the create info, the images are only created once their memory exists.
+        VkDeviceImageMemoryRequirementsKHR imageRequirements = {};
+        imageRequirements.sType       = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS_KHR;
+        imageRequirements.pCreateInfo = &entry.image->GetInfo()->image;
+
+        VkMemoryRequirements2 requirements = {};
+        requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+
+        Device::vkGetDeviceImageMemoryRequirementsKHR(m_Device->GetLogical(), &imageRequirements, &requirements);
+
+        entry.requirements = requirements.memoryRequirements;
+        m_RequestedSize   += entry.requirements.size;
+
+        order.push_back(i);
+    }
+
+    // Greedy placement, largest first, into the first compatible slot whose images all live at other times.
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        return m_Entries[a].requirements.size > m_Entries[b].requirements.size;
+    });
+
+    for (auto index : order)
+    {
+        auto& entry = m_Entries[index];
+
+        bool lazy = (entry.image->GetInfo()->image.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
+
+        for (uint32_t slotIndex = 0; slotIndex < m_Slots.size() && entry.slot == UINT32_MAX; ++slotIndex)
+        {
+            auto& slot = m_Slots[slotIndex];
+
+            // Keep transient attachments together so their slots can stay lazily allocated.
+            if (slot.lazy != lazy || (slot.requirements.memoryTypeBits & entry.requirements.memoryTypeBits) == 0)
+                continue;
+
+            bool overlaps = false;
+
+            for (auto other : slot.entries)
+                overlaps |= entry.firstUse <= m_Entries[other].lastUse && m_Entries[other].firstUse <= entry.lastUse;
+
+            if (!overlaps)
+                entry.slot = slotIndex;
+        }
+
+        if (entry.slot == UINT32_MAX)
+        {
+            Slot slot = {};
+            slot.requirements = entry.requirements;
+            slot.lazy         = lazy;
+
+            entry.slot = (uint32_t)m_Slots.size();
+            m_Slots.push_back(slot);
+        }
+
+        auto& slot = m_Slots[entry.slot];
+        slot.requirements.size            = std::max(slot.requirements.size,      entry.requirements.size);
+        slot.requirements.alignment       = std::max(slot.requirements.alignment, entry.requirements.alignment);
+        slot.requirements.memoryTypeBits &= entry.requirements.memoryTypeBits;
+        slot.entries.push_back(index);
+    }
+
+    for (auto& slot : m_Slots)
+    {
+        VmaAllocationCreateInfo allocationInfo = {};
+        allocationInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+        VkResult hr = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+
+        if (slot.lazy && m_SupportsLazyAllocation)
+        {
+            VmaAllocationCreateInfo lazyInfo = {};
+            lazyInfo.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+
+            hr = vmaAllocateMemory(m_Device->GetAllocator(), &slot.requirements, &lazyInfo, &slot.allocation, nullptr);
+        }
+
+        // No lazily allocated type for these images, fall back to regular device memory.
+        if (hr != VK_SUCCESS)
+            hr = vmaAllocateMemory(m_Device->GetAllocator(), &slot.requirements, &allocationInfo, &slot.allocation, nullptr);
+
+        if (hr != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate aliased image memory.");
+
+        m_AllocatedSize += slot.requirements.size;
+
+        for (auto index : slot.entries)
+        {
+            auto image = m_Entries[index].image;
+
+            if (vmaCreateAliasingImage(m_Device->GetAllocator(), slot.allocation, &image->GetInfo()->image, &image->GetData()->image) != VK_SUCCESS)
+                throw std::runtime_error("failed to create aliased image.");
+
+            // The memory belongs to the slot.
+            image->GetData()->allocation = VK_NULL_HANDLE;
+
+            image->GetInfo()->view.image = image->GetData()->image;
+
+            if (vkCreateImageView(m_Device->GetLogical(), &image->GetInfo()->view, nullptr, &image->GetData()->view) != VK_SUCCESS)
+                throw std::runtime_error("failed to create aliased image view.");
+
+            image->ResetState();
+
+            m_Device->GetDescriptorHeap()->Register(image);
+        }
+    }
+}
+
+void AliasingPool::Release()
+{
+    std::vector<Image*>        images;
+    std::vector<VmaAllocation> allocations;
+
+    for (auto& entry : m_Entries)
+    {
+        if (entry.image->GetData()->image != VK_NULL_HANDLE)
+            images.push_back(entry.image);
+    }
+
+    for (auto& slot : m_Slots)
+    {
+        if (slot.allocation != VK_NULL_HANDLE)
+            allocations.push_back(slot.allocation);
+    }
+
+    m_Device->ReleaseImages(images);
+    m_Device->ReleaseAllocations(allocations);
+
+    m_Entries.clear();
+    m_Slots.clear();
+
+    m_AllocatedSize = 0;
+    m_RequestedSize = 0;
+}
+
+Image* AliasingPool::Claim(uint32_t entry)
+{
+    auto& slot = m_Slots[m_Entries[entry].slot];
+
+    Image* previous = slot.lastOccupant;
+    slot.lastOccupant = m_Entries[entry].image;
+
+    return previous;
+}
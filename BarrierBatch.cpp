@@ -0,0 +1,243 @@
+#include <VulkanWrappers/BarrierBatch.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/Buffer.h>
+
+using namespace VulkanWrappers;
+
+static const VkAccessFlags2 s_WriteAccess = VK_ACCESS_2_SHADER_WRITE_BIT                  |
+                                            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT          |
+                                            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT        |
+                                            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_2_TRANSFER_WRITE_BIT                |
+                                            VK_ACCESS_2_HOST_WRITE_BIT                    |
+                                            VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+static bool IsWrite(VkAccessFlags2 access)
+{
+    return (access & s_WriteAccess) != 0;
+}
+
+// Returns false when the previous uses already cover the next one, otherwise fills the
+// barrier's source / destination scopes and moves the state on.
+template <typename Barrier, typename State>
+static bool ResolveState(State* state, bool sameLayout, VkPipelineStageFlags2 stage, VkAccessFlags2 access, Barrier* barrier)
+{
+    // Waits on the last write (made available again, a no-op if it already was) and on the reads since, which
+    // orders a write or layout change after them and chains through the barriers that made the write visible.
+    barrier->srcStageMask  = state->writeStage | state->readStages;
+    barrier->srcAccessMask = state->writeAccess;
+    barrier->dstStageMask  = stage;
+    barrier->dstAccessMask = access;
+
+    if (IsWrite(access))
+    {
+        state->writeStage    = stage;
+        state->writeAccess   = access & s_WriteAccess;
+        state->visibleStages = VK_PIPELINE_STAGE_2_NONE;
+        state->visibleAccess = VK_ACCESS_2_NONE;
+        state->readStages    = VK_PIPELINE_STAGE_2_NONE;
+
+        return true;
+    }
+
+    // A read in the same layout is covered when there is no write to wait on, or when an earlier
+    // barrier already made the write visible to this stage and access.
+    bool visible = state->writeAccess == VK_ACCESS_2_NONE ||
+                   ((stage & ~state->visibleStages) == 0 && (access & ~state->visibleAccess) == 0);
+
+    state->readStages |= stage;
+
+    if (sameLayout && visible)
+        return false;
+
+    // Past a layout change, only this barrier's destination sees the transition.
+    if (!sameLayout)
+    {
+        state->visibleStages = VK_PIPELINE_STAGE_2_NONE;
+        state->visibleAccess = VK_ACCESS_2_NONE;
+    }
+
+    state->visibleStages |= stage;
+    state->visibleAccess |= access;
+
+    return true;
+}
+
+static bool SameState(const Image::State& a, const Image::State& b)
+{
+    return a.layout        == b.layout        &&
+           a.writeStage    == b.writeStage    &&
+           a.writeAccess   == b.writeAccess   &&
+           a.visibleStages == b.visibleStages &&
+           a.visibleAccess == b.visibleAccess &&
+           a.readStages    == b.readStages;
+}
+
+static bool Overlaps(uint32_t baseA, uint32_t countA, uint32_t baseB, uint32_t countB)
+{
+    return (uint64_t)baseA < (uint64_t)baseB + countB && (uint64_t)baseB < (uint64_t)baseA + countA;
+}
+
+bool BarrierBatch::IsPending(const void* resource, const VkImageSubresourceRange* range) const
+{
+    for (auto& pending : m_PendingResources)
+    {
+        if (pending.resource != resource)
+            continue;
+
+        if (range == nullptr)
+            return true;
+
+        if (Overlaps(pending.range.baseMipLevel,   pending.range.levelCount, range->baseMipLevel,   range->levelCount) &&
+            Overlaps(pending.range.baseArrayLayer, pending.range.layerCount, range->baseArrayLayer, range->layerCount))
+            return true;
+    }
+
+    return false;
+}
+
+void BarrierBatch::Transition(Image* image, VkImageLayout layout, VkPipelineStageFlags2 stage, VkAccessFlags2 access, const VkImageSubresourceRange* range)
+{
+    auto info = image->GetInfo();
+
+    VkImageSubresourceRange subresources = {};
+    subresources.aspectMask     = info->view.subresourceRange.aspectMask;
+    subresources.baseMipLevel   = 0;
+    subresources.levelCount     = info->image.mipLevels;
+    subresources.baseArrayLayer = 0;
+    subresources.layerCount     = info->image.arrayLayers;
+
+    if (range != nullptr)
+    {
+        subresources = *range;
+
+        if (subresources.levelCount == VK_REMAINING_MIP_LEVELS)
+            subresources.levelCount = info->image.mipLevels - subresources.baseMipLevel;
+
+        if (subresources.layerCount == VK_REMAINING_ARRAY_LAYERS)
+            subresources.layerCount = info->image.arrayLayers - subresources.baseArrayLayer;
+    }
+
+    // A second transition of the same subresources must come after the first one.
+    if (IsPending(image, &subresources))
+        Flush();
+
+    VkImageMemoryBarrier2KHR imageBarrier = {};
+    imageBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+    imageBarrier.newLayout           = layout;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image               = image->GetData()->image;
+
+    // Common case: the whole range shares one state and needs a single barrier.
+    Image::State first = *image->GetState(subresources.baseMipLevel, subresources.baseArrayLayer);
+
+    bool uniform = true;
+
+    for (uint32_t layer = 0; layer < subresources.layerCount && uniform; ++layer)
+    {
+        for (uint32_t mip = 0; mip < subresources.levelCount && uniform; ++mip)
+        {
+            auto state = image->GetState(subresources.baseMipLevel + mip, subresources.baseArrayLayer + layer);
+            uniform = SameState(*state, first);
+        }
+    }
+
+    bool pending = false;
+
+    for (uint32_t layer = 0; layer < subresources.layerCount; ++layer)
+    {
+        for (uint32_t mip = 0; mip < subresources.levelCount; ++mip)
+        {
+            auto state = image->GetState(subresources.baseMipLevel + mip, subresources.baseArrayLayer + layer);
+
+            VkImageLayout oldLayout = state->layout;
+
+            if (!ResolveState(state, oldLayout == layout, stage, access, &imageBarrier))
+                continue;
+
+            // With a uniform range only the first subresource emits a barrier covering all of them.
+            if (uniform && pending)
+                continue;
+
+            imageBarrier.oldLayout        = oldLayout;
+            imageBarrier.subresourceRange = subresources;
+
+            if (!uniform)
+            {
+                imageBarrier.subresourceRange.baseMipLevel   = subresources.baseMipLevel   + mip;
+                imageBarrier.subresourceRange.levelCount     = 1u;
+                imageBarrier.subresourceRange.baseArrayLayer = subresources.baseArrayLayer + layer;
+                imageBarrier.subresourceRange.layerCount     = 1u;
+            }
+
+            m_ImageBarriers.push_back(imageBarrier);
+            pending = true;
+        }
+    }
+
+    if (pending)
+        m_PendingResources.push_back({ image, subresources });
+}
+
+void BarrierBatch::Transition(Buffer* buffer, VkPipelineStageFlags2 stage, VkAccessFlags2 access)
+{
+    if (IsPending(buffer))
+        Flush();
+
+    VkBufferMemoryBarrier2KHR bufferBarrier = {};
+    bufferBarrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+    bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferBarrier.buffer              = buffer->GetData()->buffer;
+    bufferBarrier.offset              = 0;
+    bufferBarrier.size                = VK_WHOLE_SIZE;
+
+    if (!ResolveState(buffer->GetState(), true, stage, access, &bufferBarrier))
+        return;
+
+    // Nothing touched the buffer yet.
+    if (bufferBarrier.srcStageMask == VK_PIPELINE_STAGE_2_NONE)
+        return;
+
+    m_BufferBarriers.push_back(bufferBarrier);
+    m_PendingResources.push_back({ buffer, {} });
+}
+
+void BarrierBatch::GlobalBarrier(VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess)
+{
+    if (srcStage == VK_PIPELINE_STAGE_2_NONE)
+        return;
+
+    VkMemoryBarrier2KHR memoryBarrier = {};
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+    memoryBarrier.srcStageMask  = srcStage;
+    memoryBarrier.srcAccessMask = srcAccess & s_WriteAccess;
+    memoryBarrier.dstStageMask  = dstStage;
+    memoryBarrier.dstAccessMask = dstAccess;
+
+    m_MemoryBarriers.push_back(memoryBarrier);
+}
+
+void BarrierBatch::Flush()
+{
+    if (m_MemoryBarriers.empty() && m_ImageBarriers.empty() && m_BufferBarriers.empty())
+        return;
+
+    VkDependencyInfo dependencyInfo = {};
+    dependencyInfo.sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount       = (uint32_t)m_MemoryBarriers.size();
+    dependencyInfo.pMemoryBarriers          = m_MemoryBarriers.data();
+    dependencyInfo.imageMemoryBarrierCount  = (uint32_t)m_ImageBarriers.size();
+    dependencyInfo.pImageMemoryBarriers     = m_ImageBarriers.data();
+    dependencyInfo.bufferMemoryBarrierCount = (uint32_t)m_BufferBarriers.size();
+    dependencyInfo.pBufferMemoryBarriers    = m_BufferBarriers.data();
+
+    Device::vkCmdPipelineBarrier2KHR(m_CommandBuffer, &dependencyInfo);
+
+    m_MemoryBarriers.clear();
+    m_ImageBarriers.clear();
+    m_BufferBarriers.clear();
+    m_PendingResources.clear();
+}
@@ -0,0 +1,396 @@
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Headless.h>
+#include <VulkanWrappers/Buffer.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/Shader.h>
+#include <VulkanWrappers/StateCache.h>
+#include <VulkanWrappers/BarrierBatch.h>
+#include <VulkanWrappers/MappedFile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace VulkanWrappers;
+
+// Microbenchmarks of the CPU cost of the wrappers: resource creation, command recording and the headless frame
+// loop. Only a Vulkan 1.3 driver with VK_EXT_shader_object is needed, so it runs on lavapipe on GPU-less machines
+// (SwiftShader lacks shader objects and needs the Khronos shader object emulation layer). Results are printed as
+// one JSON document, each benchmark reporting the median and minimum nanoseconds per operation over its repeats.
+// Only compare results obtained with the same driver.
+//
+//   VulkanWrappersBench [--repeats N] [--output results.json]
+
+#ifndef BENCH_SHADER_DIR
+#define BENCH_SHADER_DIR "."
+#endif
+
+#define BENCH_BUFFER_COUNT  512u
+#define BENCH_IMAGE_COUNT   128u
+#define BENCH_SHADER_COUNT  32u
+#define BENCH_RECORD_COUNT  4096u
+#define BENCH_FRAME_COUNT   256u
+#define BENCH_BARRIER_BATCH 8u
+
+// Harness
+// ----------------------------------------
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchResult
+{
+    const char* name;
+    uint32_t    operations;
+    double      medianNs;
+    double      minNs;
+};
+
+static uint32_t                 s_Repeats = 10;
+static std::vector<BenchResult> s_Results;
+
+static double ElapsedNs(Clock::time_point begin)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+}
+
+// The body performs the operations and returns the nanoseconds spent on the measured part, so setup and cleanup
+// stay out of the timings. A first unmeasured run warms up allocators and driver caches.
+template <typename Body>
+static void Run(const char* name, uint32_t operations, Body body)
+{
+    body();
+
+    std::vector<double> samples;
+
+    for (uint32_t i = 0; i < s_Repeats; ++i)
+        samples.push_back(body() / operations);
+
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result = {};
+    result.name       = name;
+    result.operations = operations;
+    result.medianNs   = samples[samples.size() / 2];
+    result.minNs      = samples.front();
+
+    s_Results.push_back(result);
+
+    fprintf(stderr, "%-36s %12.1f ns/op\n", name, result.medianNs);
+}
+
+static void WriteResults(FILE* file, const VkPhysicalDeviceProperties& properties)
+{
+    fprintf(file, "{\n");
+    fprintf(file, "  \"device\": \"%s\",\n", properties.deviceName);
+    fprintf(file, "  \"driverVersion\": %u,\n", properties.driverVersion);
+    fprintf(file, "  \"repeats\": %u,\n", s_Repeats);
+    fprintf(file, "  \"benchmarks\": [\n");
+
+    for (size_t i = 0; i < s_Results.size(); ++i)
+    {
+        auto& result = s_Results[i];
+
+        fprintf(file, "    { \"name\": \"%s\", \"operations\": %u, \"median_ns\": %.1f, \"min_ns\": %.1f }%s\n",
+                result.name, result.operations, result.medianNs, result.minNs, i + 1 < s_Results.size() ? "," : "");
+    }
+
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+}
+
+// Frames
+// ----------------------------------------
+
+static void BeginFrame(Device* device, Headless* headless, Frame* frame)
+{
+    headless->NextFrame(device, frame);
+
+    // The target has to end the frame as a color attachment.
+    Image::TransferUnknownToWrite(frame->commandBuffer, frame->backBuffer);
+}
+
+// Submits an empty frame and waits for it, so everything released before it is destroyed.
+static void Drain(Device* device, Headless* headless)
+{
+    Frame frame;
+    BeginFrame(device, headless, &frame);
+    headless->SubmitFrame(device, &frame);
+
+    device->WaitForFrame(frame.number);
+    device->CollectReleases();
+}
+
+// Times a recording loop into a frame's command buffer, the frame is then submitted like any other.
+template <typename Record>
+static double RecordFrame(Device* device, Headless* headless, Record record)
+{
+    Frame frame;
+    BeginFrame(device, headless, &frame);
+
+    auto begin = Clock::now();
+    record(&frame);
+    double ns = ElapsedNs(begin);
+
+    headless->SubmitFrame(device, &frame);
+
+    return ns;
+}
+
+// Benchmarks
+// ----------------------------------------
+
+static void BenchCreation(Device* device, Headless* headless, const MappedFile& vertexCode, const MappedFile& fragmentCode)
+{
+    Run("Device::CreateBuffers", BENCH_BUFFER_COUNT, [&]()
+    {
+        std::vector<Buffer>  buffers(BENCH_BUFFER_COUNT, Buffer(64u * 1024u, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0x0));
+        std::vector<Buffer*> pointers;
+
+        for (auto& buffer : buffers)
+            pointers.push_back(&buffer);
+
+        auto begin = Clock::now();
+        device->CreateBuffers(pointers);
+        double ns = ElapsedNs(begin);
+
+        device->ReleaseBuffers(pointers);
+        Drain(device, headless);
+
+        return ns;
+    });
+
+    Run("Device::CreateImages", BENCH_IMAGE_COUNT, [&]()
+    {
+        std::vector<Image>  images(BENCH_IMAGE_COUNT, Image(256u, 256u, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_IMAGE_ASPECT_COLOR_BIT));
+        std::vector<Image*> pointers;
+
+        for (auto& image : images)
+            pointers.push_back(&image);
+
+        auto begin = Clock::now();
+        device->CreateImages(pointers);
+        double ns = ElapsedNs(begin);
+
+        device->ReleaseImages(pointers);
+        Drain(device, headless);
+
+        return ns;
+    });
+
+    // One operation is a vertex + fragment pair, without a shader cache.
+    Run("Device::CreateShaders", BENCH_SHADER_COUNT, [&]()
+    {
+        std::vector<Shader>  shaders;
+        std::vector<Shader*> pointers;
+
+        shaders.reserve(BENCH_SHADER_COUNT * 2);
+
+        for (uint32_t i = 0; i < BENCH_SHADER_COUNT; ++i)
+        {
+            shaders.emplace_back(vertexCode.GetData(), vertexCode.GetSize(), VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT);
+            shaders.emplace_back(fragmentCode.GetData(), fragmentCode.GetSize(), VK_SHADER_STAGE_FRAGMENT_BIT);
+        }
+
+        for (auto& shader : shaders)
+            pointers.push_back(&shader);
+
+        auto begin = Clock::now();
+        device->CreateShaders(pointers);
+        double ns = ElapsedNs(begin);
+
+        device->ReleaseShaders(pointers);
+        Drain(device, headless);
+
+        return ns;
+    });
+}
+
+static void BenchRecording(Device* device, Headless* headless, const MappedFile& vertexCode, const MappedFile& fragmentCode)
+{
+    Shader vertex  (vertexCode.GetData(), vertexCode.GetSize(), VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT);
+    Shader fragment(fragmentCode.GetData(), fragmentCode.GetSize(), VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    device->CreateShaders({ &vertex, &fragment });
+
+    ShaderProgram program(device, { &vertex, &fragment });
+
+    Run("Device::SetDefaultRenderState", BENCH_RECORD_COUNT, [&]()
+    {
+        return RecordFrame(device, headless, [&](Frame* frame)
+        {
+            for (uint32_t i = 0; i < BENCH_RECORD_COUNT; ++i)
+                Device::SetDefaultRenderState(frame->commandBuffer);
+        });
+    });
+
+    // Every call after the first is filtered out by the cache.
+    Run("StateCache::SetState (redundant)", BENCH_RECORD_COUNT, [&]()
+    {
+        auto state = RenderState::Default();
+
+        return RecordFrame(device, headless, [&](Frame* frame)
+        {
+            for (uint32_t i = 0; i < BENCH_RECORD_COUNT; ++i)
+                frame->stateCache.SetState(state);
+        });
+    });
+
+    Run("Shader::Bind", BENCH_RECORD_COUNT, [&]()
+    {
+        return RecordFrame(device, headless, [&](Frame* frame)
+        {
+            for (uint32_t i = 0; i < BENCH_RECORD_COUNT; ++i)
+                Shader::Bind(frame->commandBuffer, i & 1 ? fragment : vertex);
+        });
+    });
+
+    Run("ShaderProgram::Bind", BENCH_RECORD_COUNT, [&]()
+    {
+        return RecordFrame(device, headless, [&](Frame* frame)
+        {
+            for (uint32_t i = 0; i < BENCH_RECORD_COUNT; ++i)
+                ShaderProgram::Bind(frame->commandBuffer, program);
+        });
+    });
+
+    device->ReleaseShaders({ &vertex, &fragment });
+}
+
+static void BenchBarriers(Device* device, Headless* headless)
+{
+    std::vector<Image>  images(BENCH_BARRIER_BATCH, Image(64u, 64u, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_IMAGE_ASPECT_COLOR_BIT));
+    std::vector<Image*> pointers;
+
+    for (auto& image : images)
+        pointers.push_back(&image);
+
+    device->CreateImages(pointers);
+
+    // Alternates between two uses so no transition is skipped as redundant.
+    auto transition = [](BarrierBatch* batch, Image* image, uint32_t i)
+    {
+        if (i & 1)
+            batch->Transition(image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+        else
+            batch->Transition(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    };
+
+    Run("BarrierBatch (1 image)", BENCH_RECORD_COUNT, [&]()
+    {
+        return RecordFrame(device, headless, [&](Frame* frame)
+        {
+            for (uint32_t i = 0; i < BENCH_RECORD_COUNT; ++i)
+            {
+                BarrierBatch batch(frame->commandBuffer);
+                transition(&batch, pointers[0], i);
+            }
+        });
+    });
+
+    // One operation is one transition, flushed BENCH_BARRIER_BATCH at a time.
+    Run("BarrierBatch (8 images)", BENCH_RECORD_COUNT, [&]()
+    {
+        return RecordFrame(device, headless, [&](Frame* frame)
+        {
+            for (uint32_t i = 0; i < BENCH_RECORD_COUNT / BENCH_BARRIER_BATCH; ++i)
+            {
+                BarrierBatch batch(frame->commandBuffer);
+
+                for (auto image : pointers)
+                    transition(&batch, image, i);
+            }
+        });
+    });
+
+    device->ReleaseImages(pointers);
+    Drain(device, headless);
+}
+
+// Empty frames through the whole loop: pacing, command buffer recycling, submit and readback copy.
+static void BenchFrames(Device* device, Headless* headless)
+{
+    Run("Headless frame", BENCH_FRAME_COUNT, [&]()
+    {
+        Frame frame;
+
+        auto begin = Clock::now();
+
+        for (uint32_t i = 0; i < BENCH_FRAME_COUNT; ++i)
+        {
+            BeginFrame(device, headless, &frame);
+            headless->SubmitFrame(device, &frame);
+        }
+
+        device->WaitForFrame(frame.number);
+
+        return ElapsedNs(begin);
+    });
+}
+
+// Main
+// ----------------------------------------
+
+int main(int argc, char** argv)
+{
+    const char* outputPath = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc)
+            s_Repeats = std::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            outputPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--repeats N] [--output results.json]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    try
+    {
+        MappedFile vertexCode, fragmentCode;
+
+        if (!vertexCode.Open(BENCH_SHADER_DIR "/Bench.vert.spv") || !fragmentCode.Open(BENCH_SHADER_DIR "/Bench.frag.spv"))
+            throw std::runtime_error("failed to read benchmark shaders.");
+
+        Device device;
+
+        VkPhysicalDeviceProperties properties = {};
+        vkGetPhysicalDeviceProperties(device.GetPhysical(), &properties);
+
+        fprintf(stderr, "Running on %s.\n", properties.deviceName);
+
+        {
+            Headless headless(&device, 256u, 256u);
+
+            BenchCreation (&device, &headless, vertexCode, fragmentCode);
+            BenchRecording(&device, &headless, vertexCode, fragmentCode);
+            BenchBarriers (&device, &headless);
+            BenchFrames   (&device, &headless);
+
+            vkDeviceWaitIdle(device.GetLogical());
+        }
+
+        FILE* file = outputPath != nullptr ? fopen(outputPath, "w") : stdout;
+
+        if (file == nullptr)
+            throw std::runtime_error("failed to open the output file.");
+
+        WriteResults(file, properties);
+
+        if (file != stdout)
+            fclose(file);
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
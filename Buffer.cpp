@@ -1,5 +1,7 @@
 #include <VulkanWrappers/Buffer.h>
 #include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/StagingRing.h>
 
 using namespace VulkanWrappers;
 
@@ -11,7 +13,7 @@ Buffer::Buffer(VkDeviceSize             size,
 
     m_Info.buffer.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     m_Info.buffer.size = size;
-    m_Info.buffer.usage = useFlags;
+    m_Info.buffer.usage = useFlags | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
     m_Info.buffer.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     m_Info.view = {};
@@ -28,6 +30,74 @@ Buffer::Buffer(VkDeviceSize             size,
     m_Info.allocation.priority = 1.0;
 }
 
+void Buffer::SetData(Device* device, Buffer* buffer, const void* srcPtr, uint32_t size, VkDeviceSize offset)
+{
+    const VmaAllocationCreateFlags hostAccessFlags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | 
+                                                     VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+
+    if (offset + size > buffer->GetInfo()->buffer.size)
+        throw std::runtime_error("buffer write is out of the buffer's range.");
+
+    if (buffer->GetInfo()->allocation.flags & hostAccessFlags)
+    {
+        // VMA may still have placed the allocation in non-mappable memory.
+        VkMemoryPropertyFlags memoryProperties = 0;
+        vmaGetAllocationMemoryProperties(device->GetAllocator(), buffer->GetData()->allocation, &memoryProperties);
+
+        if (memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            if (vmaCopyMemoryToAllocation(device->GetAllocator(), srcPtr, buffer->GetData()->allocation, offset, size) != VK_SUCCESS)
+                throw std::runtime_error("failed to write buffer memory.");
+
+            return;
+        }
+    }
+
+    if (!(buffer->GetInfo()->buffer.usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+        throw std::runtime_error("staged buffer writes require VK_BUFFER_USAGE_TRANSFER_DST_BIT.");
+
+    device->GetStagingRing()->Upload(buffer, offset, srcPtr, size);
+}
+
+static void OwnershipBarrier(VkCommandBuffer cmd, Buffer* buffer, uint32_t srcFamily, uint32_t dstFamily, 
+                             VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, 
+                             VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess)
+{
+    if (srcFamily == dstFamily)
+        return;
+
+    VkBufferMemoryBarrier2KHR bufferBarrier = {};
+    bufferBarrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+    bufferBarrier.srcStageMask        = srcStage;
+    bufferBarrier.srcAccessMask       = srcAccess;
+    bufferBarrier.dstStageMask        = dstStage;
+    bufferBarrier.dstAccessMask       = dstAccess;
+    bufferBarrier.srcQueueFamilyIndex = srcFamily;
+    bufferBarrier.dstQueueFamilyIndex = dstFamily;
+    bufferBarrier.buffer              = buffer->GetData()->buffer;
+    bufferBarrier.offset              = 0;
+    bufferBarrier.size                = VK_WHOLE_SIZE;
+
+    VkDependencyInfo dependencyInfo = {};
+    dependencyInfo.sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.bufferMemoryBarrierCount = 1u;
+    dependencyInfo.pBufferMemoryBarriers    = &bufferBarrier;
+
+    Device::vkCmdPipelineBarrier2KHR(cmd, &dependencyInfo);
+}
+
+void Buffer::ReleaseOwnership(VkCommandBuffer cmd, Buffer* buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess)
+{
+    // Destination scope is ignored for a release.
+    OwnershipBarrier(cmd, buffer, srcFamily, dstFamily, srcStage, srcAccess, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE);
+}
+
+void Buffer::AcquireOwnership(VkCommandBuffer cmd, Buffer* buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess)
+{
+    // Source scope is ignored for an acquire.
+    OwnershipBarrier(cmd, buffer, srcFamily, dstFamily, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, dstStage, dstAccess);
+}
+
 void Buffer::CopyImage(VkCommandBuffer cmd, Image* image, Buffer* buffer)
 {
     VkBufferImageCopy copyInfo = {};
@@ -0,0 +1,129 @@
+#include <VulkanWrappers/BufferArena.h>
+#include <VulkanWrappers/Device.h>
+
+#include <algorithm>
+
+using namespace VulkanWrappers;
+
+BufferArena::BufferArena(Device* device, VkDeviceSize blockSize, VkBufferUsageFlags usage, VmaAllocationCreateFlags memFlags, bool linear)
+    : m_Device(device), m_BlockSize(blockSize), m_Usage(usage), m_MemFlags(memFlags), m_MinAlignment(4), m_Linear(linear)
+{
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(device->GetPhysical(), &properties);
+
+    // Slices must be bindable at their offset for every usage of the arena.
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        m_MinAlignment = std::max(m_MinAlignment, properties.limits.minUniformBufferOffsetAlignment);
+
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+        m_MinAlignment = std::max(m_MinAlignment, properties.limits.minStorageBufferOffsetAlignment);
+
+    if (usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT))
+        m_MinAlignment = std::max(m_MinAlignment, properties.limits.minTexelBufferOffsetAlignment);
+
+    AddBlock();
+}
+
+BufferArena::~BufferArena()
+{
+    std::vector<Buffer*> buffers;
+
+    for (auto& block : m_Blocks)
+    {
+        // Outstanding slices are dropped with the arena.
+        vmaClearVirtualBlock(block.virtualBlock);
+        vmaDestroyVirtualBlock(block.virtualBlock);
+
+        buffers.push_back(block.buffer.get());
+    }
+
+    m_Device->ReleaseBuffers(buffers);
+}
+
+void BufferArena::AddBlock()
+{
+    Block block = {};
+    block.buffer = std::make_unique<Buffer>(m_BlockSize, m_Usage, m_MemFlags);
+
+    m_Device->CreateBuffers({ block.buffer.get() });
+
+    VmaAllocationInfo allocationInfo = {};
+    vmaGetAllocationInfo(m_Device->GetAllocator(), block.buffer->GetData()->allocation, &allocationInfo);
+
+    block.mapped = allocationInfo.pMappedData;
+
+    VmaVirtualBlockCreateInfo virtualBlockInfo = {};
+    virtualBlockInfo.size  = m_BlockSize;
+    virtualBlockInfo.flags = m_Linear ? VMA_VIRTUAL_BLOCK_CREATE_LINEAR_ALGORITHM_BIT : 0x0;
+
+    if (vmaCreateVirtualBlock(&virtualBlockInfo, &block.virtualBlock) != VK_SUCCESS)
+        throw std::runtime_error("failed to create buffer arena block.");
+
+    m_Blocks.push_back(std::move(block));
+}
+
+BufferSlice BufferArena::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (size > m_BlockSize)
+        throw std::runtime_error("buffer arena allocation is larger than a block.");
+
+    VmaVirtualAllocationCreateInfo allocationInfo = {};
+    allocationInfo.size      = size;
+    allocationInfo.alignment = std::max(alignment, m_MinAlignment);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    BufferSlice slice = {};
+
+    // The newest block is the most likely to have room.
+    for (uint32_t i = (uint32_t)m_Blocks.size(); i-- > 0;)
+    {
+        if (vmaVirtualAllocate(m_Blocks[i].virtualBlock, &allocationInfo, &slice.allocation, &slice.offset) == VK_SUCCESS)
+        {
+            slice.block = i;
+            break;
+        }
+    }
+
+    if (slice.allocation == VK_NULL_HANDLE)
+    {
+        AddBlock();
+
+        slice.block = (uint32_t)m_Blocks.size() - 1;
+
+        if (vmaVirtualAllocate(m_Blocks[slice.block].virtualBlock, &allocationInfo, &slice.allocation, &slice.offset) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate from buffer arena.");
+    }
+
+    auto& block = m_Blocks[slice.block];
+
+    slice.buffer  = block.buffer.get();
+    slice.size    = size;
+    slice.mapped  = block.mapped != nullptr ? static_cast<uint8_t*>(block.mapped) + slice.offset : nullptr;
+    slice.address = block.buffer->GetData()->address + slice.offset;
+
+    return slice;
+}
+
+void BufferArena::Free(const BufferSlice& slice)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    vmaVirtualFree(m_Blocks[slice.block].virtualBlock, slice.allocation);
+}
+
+void BufferArena::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (auto& block : m_Blocks)
+        vmaClearVirtualBlock(block.virtualBlock);
+}
+
+void BufferArena::SetData(const BufferSlice& slice, const void* srcPtr, uint32_t size, VkDeviceSize offset)
+{
+    if (offset + size > slice.size)
+        throw std::runtime_error("buffer arena write is out of the slice's range.");
+
+    Buffer::SetData(m_Device, slice.buffer, srcPtr, size, slice.offset + offset);
+}
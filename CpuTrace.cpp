@@ -0,0 +1,121 @@
+#include <VulkanWrappers/CpuTrace.h>
+
+#ifdef VULKAN_WRAPPERS_TRACE
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <vector>
+
+using namespace VulkanWrappers;
+
+// Per-thread Rings
+// ----------------------------------------
+
+struct TraceEvent
+{
+    const char* name;
+    uint64_t    begin;
+    uint64_t    end;
+};
+
+// Single writer (the owning thread), the head is published after the event is written.
+struct ThreadRing
+{
+    uint32_t                                    threadId;
+    std::atomic<uint64_t>                       head;
+    std::array<TraceEvent, CPU_TRACE_RING_SIZE> events;
+};
+
+// Rings outlive their threads so their events can still be exported.
+static std::mutex                               s_RingsMutex;
+static std::vector<std::unique_ptr<ThreadRing>> s_Rings;
+
+static ThreadRing* GetThreadRing()
+{
+    thread_local ThreadRing* t_Ring = nullptr;
+
+    if (t_Ring == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(s_RingsMutex);
+
+        s_Rings.push_back(std::make_unique<ThreadRing>());
+
+        t_Ring = s_Rings.back().get();
+        t_Ring->threadId = (uint32_t)s_Rings.size();
+        t_Ring->head.store(0, std::memory_order_relaxed);
+    }
+
+    return t_Ring;
+}
+
+uint64_t CpuTrace::Now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CpuTrace::Record(const char* name, uint64_t begin, uint64_t end)
+{
+    auto ring = GetThreadRing();
+    auto head = ring->head.load(std::memory_order_relaxed);
+
+    ring->events[head % CPU_TRACE_RING_SIZE] = { name, begin, end };
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+// Export
+// ----------------------------------------
+
+static void WriteEscaped(FILE* file, const char* text)
+{
+    for (; *text != '\0'; ++text)
+    {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', file);
+
+        fputc(*text, file);
+    }
+}
+
+bool CpuTrace::WriteChromeTrace(const char* filePath)
+{
+    FILE* file = fopen(filePath, "w");
+
+    if (file == nullptr)
+        return false;
+
+    fputs("{\"traceEvents\":[\n", file);
+
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(s_RingsMutex);
+
+    for (auto& ring : s_Rings)
+    {
+        uint64_t head  = ring->head.load(std::memory_order_acquire);
+        uint64_t start = head > CPU_TRACE_RING_SIZE ? head - CPU_TRACE_RING_SIZE : 0;
+
+        for (uint64_t i = start; i < head; ++i)
+        {
+            auto& event = ring->events[i % CPU_TRACE_RING_SIZE];
+
+            fputs(first ? "{\"name\":\"" : ",\n{\"name\":\"", file);
+            WriteEscaped(file, event.name);
+
+            // Complete events, in microseconds.
+            fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    ring->threadId, event.begin / 1000.0, (event.end - event.begin) / 1000.0);
+
+            first = false;
+        }
+    }
+
+    fputs("\n]}\n", file);
+
+    return fclose(file) == 0;
+}
+
+#endif//VULKAN_WRAPPERS_TRACE
@@ -0,0 +1,287 @@
+#include <VulkanWrappers/DescriptorHeap.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/Buffer.h>
+
+#include <algorithm>
+
+using namespace VulkanWrappers;
+
+static const VkDescriptorType s_DescriptorTypes[DescriptorHeap::BindingCount] =
+{
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_SAMPLER
+};
+
+// Upper bounds for each array, clamped to what the device supports.
+static const uint32_t s_DefaultCapacities[DescriptorHeap::BindingCount] =
+{
+    65536u,
+    8192u,
+    65536u,
+    256u
+};
+
+static VkImageLayout GetSampledLayout(Image* image)
+{
+    // Matches the read-only layout depth images are transitioned to (see RenderGraph::Access::DepthRead).
+    if (image->GetInfo()->view.subresourceRange.aspectMask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT))
+        return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+    return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+DescriptorHeap::DescriptorHeap(Device* device)
+    : m_Device(device), m_VKSet(VK_NULL_HANDLE)
+{
+    VkPhysicalDeviceVulkan12Properties properties12 = {};
+    properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &properties12;
+
+    vkGetPhysicalDeviceProperties2(device->GetPhysical(), &properties);
+
+    const uint32_t deviceLimits[BindingCount] =
+    {
+        std::min(properties12.maxPerStageDescriptorUpdateAfterBindSampledImages, properties12.maxDescriptorSetUpdateAfterBindSampledImages),
+        std::min(properties12.maxPerStageDescriptorUpdateAfterBindStorageImages, properties12.maxDescriptorSetUpdateAfterBindStorageImages),
+        std::min(properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers, properties12.maxDescriptorSetUpdateAfterBindStorageBuffers),
+        std::min(properties12.maxPerStageDescriptorUpdateAfterBindSamplers, properties12.maxDescriptorSetUpdateAfterBindSamplers)
+    };
+
+    // Set Layout
+    // ---------------------
+
+    std::array<VkDescriptorSetLayoutBinding, BindingCount> bindings     = {};
+    std::array<VkDescriptorBindingFlags,     BindingCount> bindingFlags = {};
+    std::array<VkDescriptorPoolSize,         BindingCount> poolSizes    = {};
+
+    for (uint32_t binding = 0; binding < BindingCount; ++binding)
+    {
+        auto& table = m_Tables[binding];
+        table.capacity = std::min(s_DefaultCapacities[binding], deviceLimits[binding]);
+
+        // Index 0 stays unused.
+        table.next = 1u;
+
+        bindings[binding].binding         = binding;
+        bindings[binding].descriptorType  = s_DescriptorTypes[binding];
+        bindings[binding].descriptorCount = table.capacity;
+        bindings[binding].stageFlags      = VK_SHADER_STAGE_ALL;
+
+        // Entries are written while command buffers using other entries are pending.
+        bindingFlags[binding] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+        poolSizes[binding].type            = s_DescriptorTypes[binding];
+        poolSizes[binding].descriptorCount = table.capacity;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+    bindingFlagsInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount  = BindingCount;
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {};
+    setLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.pNext        = &bindingFlagsInfo;
+    setLayoutInfo.flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    setLayoutInfo.bindingCount = BindingCount;
+    setLayoutInfo.pBindings    = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device->GetLogical(), &setLayoutInfo, nullptr, &m_VKSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor heap layout.");
+
+    // Pool / Set
+    // ---------------------
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags         = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets       = 1u;
+    poolInfo.poolSizeCount = BindingCount;
+    poolInfo.pPoolSizes    = poolSizes.data();
+
+    if (vkCreateDescriptorPool(device->GetLogical(), &poolInfo, nullptr, &m_VKPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create descriptor heap pool.");
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool     = m_VKPool;
+    setInfo.descriptorSetCount = 1u;
+    setInfo.pSetLayouts        = &m_VKSetLayout;
+
+    if (vkAllocateDescriptorSets(device->GetLogical(), &setInfo, &m_VKSet) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate descriptor heap set.");
+}
+
+DescriptorHeap::~DescriptorHeap()
+{
+    for (auto& sampler : m_Samplers)
+        vkDestroySampler(m_Device->GetLogical(), sampler, nullptr);
+
+    // Destroying the pool frees the set.
+    vkDestroyDescriptorPool(m_Device->GetLogical(), m_VKPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device->GetLogical(), m_VKSetLayout, nullptr);
+}
+
+uint32_t DescriptorHeap::Allocate(Binding binding)
+{
+    auto& table = m_Tables[binding];
+
+    if (!table.freeIndices.empty())
+    {
+        uint32_t index = table.freeIndices.back();
+        table.freeIndices.pop_back();
+
+        return index;
+    }
+
+    if (table.next == table.capacity)
+        throw std::runtime_error("descriptor heap is full.");
+
+    return table.next++;
+}
+
+void DescriptorHeap::Free(Binding binding, uint32_t index)
+{
+    if (index == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Tables[binding].freeIndices.push_back(index);
+}
+
+void DescriptorHeap::Register(Image* image)
+{
+    auto usage = image->GetInfo()->image.usage;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if ((usage & VK_IMAGE_USAGE_SAMPLED_BIT) && image->GetData()->sampledIndex == 0)
+        image->GetData()->sampledIndex = Allocate(SampledImages);
+
+    // Storage views must have a single level, mipmapped images expose level 0 through their level views.
+    bool hasStorageView = image->GetInfo()->image.mipLevels == 1 || !image->GetData()->levelViews.empty();
+
+    if ((usage & VK_IMAGE_USAGE_STORAGE_BIT) && hasStorageView && image->GetData()->storageIndex == 0)
+        image->GetData()->storageIndex = Allocate(StorageImages);
+
+    WriteImage(image);
+}
+
+void DescriptorHeap::Register(Buffer* buffer)
+{
+    if (!(buffer->GetInfo()->buffer.usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (buffer->GetData()->storageIndex == 0)
+        buffer->GetData()->storageIndex = Allocate(StorageBuffers);
+
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = buffer->GetData()->buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range  = VK_WHOLE_SIZE;
+
+    VkWriteDescriptorSet write = {};
+    write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet          = m_VKSet;
+    write.dstBinding      = StorageBuffers;
+    write.dstArrayElement = buffer->GetData()->storageIndex;
+    write.descriptorCount = 1u;
+    write.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo     = &bufferInfo;
+
+    vkUpdateDescriptorSets(m_Device->GetLogical(), 1u, &write, 0u, nullptr);
+}
+
+void DescriptorHeap::Update(Image* image)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    WriteImage(image);
+}
+
+void DescriptorHeap::WriteImage(Image* image)
+{
+    auto data = image->GetData();
+
+    std::array<VkDescriptorImageInfo, 2> imageInfos = {};
+    std::array<VkWriteDescriptorSet,  2> writes     = {};
+
+    uint32_t writeCount = 0;
+
+    if (data->sampledIndex != 0)
+    {
+        imageInfos[writeCount].imageView   = data->view;
+        imageInfos[writeCount].imageLayout = GetSampledLayout(image);
+
+        writes[writeCount].dstBinding      = SampledImages;
+        writes[writeCount].dstArrayElement = data->sampledIndex;
+        writes[writeCount].descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writeCount++;
+    }
+
+    if (data->storageIndex != 0)
+    {
+        imageInfos[writeCount].imageView   = data->levelViews.empty() ? data->view : data->levelViews[0];
+        imageInfos[writeCount].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        writes[writeCount].dstBinding      = StorageImages;
+        writes[writeCount].dstArrayElement = data->storageIndex;
+        writes[writeCount].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writeCount++;
+    }
+
+    for (uint32_t i = 0; i < writeCount; ++i)
+    {
+        writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet          = m_VKSet;
+        writes[i].descriptorCount = 1u;
+        writes[i].pImageInfo      = &imageInfos[i];
+    }
+
+    if (writeCount > 0)
+        vkUpdateDescriptorSets(m_Device->GetLogical(), writeCount, writes.data(), 0u, nullptr);
+}
+
+uint32_t DescriptorHeap::CreateSampler(const VkSamplerCreateInfo& samplerInfo)
+{
+    VkSampler sampler;
+
+    if (vkCreateSampler(m_Device->GetLogical(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+        throw std::runtime_error("failed to create sampler.");
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Samplers.push_back(sampler);
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.sampler = sampler;
+
+    VkWriteDescriptorSet write = {};
+    write.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet          = m_VKSet;
+    write.dstBinding      = Samplers;
+    write.dstArrayElement = Allocate(Samplers);
+    write.descriptorCount = 1u;
+    write.descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLER;
+    write.pImageInfo      = &imageInfo;
+
+    vkUpdateDescriptorSets(m_Device->GetLogical(), 1u, &write, 0u, nullptr);
+
+    return write.dstArrayElement;
+}
+
+void DescriptorHeap::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint) const
+{
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, m_Device->GetPipelineLayout(), 0u, 1u, &m_VKSet, 0u, nullptr);
+}
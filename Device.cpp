@@ -3,8 +3,20 @@
 #include <VulkanWrappers/Shader.h>
 #include <VulkanWrappers/Buffer.h>
 #include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/StagingRing.h>
+#include <VulkanWrappers/ShaderCache.h>
+#include <VulkanWrappers/TaskPool.h>
+#include <VulkanWrappers/FrameCommandPools.h>
+#include <VulkanWrappers/FrameAllocator.h>
+#include <VulkanWrappers/DescriptorHeap.h>
+#include <VulkanWrappers/StateCache.h>
+#include <VulkanWrappers/CpuTrace.h>
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <assert.h>
 
@@ -18,6 +30,7 @@ DECLARE_VK_FUNC(vkCmdEndRenderingKHR);
 DECLARE_VK_FUNC(vkCmdPipelineBarrier2KHR);
 DECLARE_VK_FUNC(vkCreateShadersEXT);
 DECLARE_VK_FUNC(vkDestroyShaderEXT);
+DECLARE_VK_FUNC(vkGetShaderBinaryDataEXT);
 DECLARE_VK_FUNC(vkCmdBindShadersEXT);
 DECLARE_VK_FUNC(vkCmdSetPrimitiveTopologyEXT);
 DECLARE_VK_FUNC(vkCmdSetColorWriteMaskEXT);
@@ -37,9 +50,12 @@ DECLARE_VK_FUNC(vkCmdSetViewportWithCountEXT);
 DECLARE_VK_FUNC(vkCmdSetScissorWithCountEXT);
 DECLARE_VK_FUNC(vkCmdSetRasterizationSamplesEXT);
 DECLARE_VK_FUNC(vkCmdSetSampleMaskEXT);
+DECLARE_VK_FUNC(vkCmdBlitImage2KHR);
+DECLARE_VK_FUNC(vkCmdWriteTimestamp2KHR);
+DECLARE_VK_FUNC(vkGetDeviceImageMemoryRequirementsKHR);
 
 Device::Device(Window* window)
-    : m_Window(window)
+    : m_AcquiredFrame(0), m_ShaderCache(nullptr), m_GpuProfiler(nullptr), m_Window(window)
 {
     // Create Vulkan Instance
 
@@ -129,54 +145,116 @@ Device::Device(Window* window)
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(m_VKDevicePhysical, &queueFamilyCount, queueFamilies.data());
 
+    std::vector<VkBool32> presentSupport(queueFamilyCount, VK_FALSE);
+
+    m_VKQueueGraphicsIndex = UINT32_MAX;
+    m_VKQueuePresentIndex  = UINT32_MAX;
+    m_VKQueueTransferIndex = UINT32_MAX;
+    m_VKQueueComputeIndex  = UINT32_MAX;
+
     for (uint32_t i = 0; i < queueFamilyCount; i++)
     {
-        if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) 
+        VkQueueFlags queueFlags = queueFamilies[i].queueFlags;
+
+        // Don't bother handling present support if there's no window being drawn to. 
+        if (window != nullptr)
+            vkGetPhysicalDeviceSurfaceSupportKHR(m_VKDevicePhysical, i, window->GetVulkanSurface(), &presentSupport[i]);
+
+        // Prefer a graphics family that can also present.
+        if ((queueFlags & VK_QUEUE_GRAPHICS_BIT) && (m_VKQueueGraphicsIndex == UINT32_MAX || (presentSupport[i] && !presentSupport[m_VKQueueGraphicsIndex])))
             m_VKQueueGraphicsIndex = i;
 
-        if (window == nullptr)
+        // Transfer-only families usually map to the copy engines.
+        if ((queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) && m_VKQueueTransferIndex == UINT32_MAX)
+            m_VKQueueTransferIndex = i;
+
+        // Async compute.
+        if ((queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFlags & VK_QUEUE_GRAPHICS_BIT) && m_VKQueueComputeIndex == UINT32_MAX)
+            m_VKQueueComputeIndex = i;
+    }
+
+    if (m_VKQueueGraphicsIndex == UINT32_MAX)
+        throw std::runtime_error("no graphics queue for the device.");
+
+    if (window != nullptr)
+    {
+        if (presentSupport[m_VKQueueGraphicsIndex])
+            m_VKQueuePresentIndex = m_VKQueueGraphicsIndex;
+        else
         {
-            // Don't bother handling present support if there's no window being drawn to. 
-            continue;
+            for (uint32_t i = 0; i < queueFamilyCount && m_VKQueuePresentIndex == UINT32_MAX; i++)
+            {
+                if (presentSupport[i])
+                    m_VKQueuePresentIndex = i;
+            }
         }
-        
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(m_VKDevicePhysical, i, window->GetVulkanSurface(), &presentSupport);
 
-        if (!presentSupport)
-            continue;
-
-        m_VKQueuePresentIndex = i;
+        if (m_VKQueuePresentIndex == UINT32_MAX)
+            throw std::runtime_error("no present queue for the device.");
     }
 
+    // Without dedicated families, transfer and compute work goes to the graphics queue.
+    m_HasDedicatedTransferQueue = m_VKQueueTransferIndex != UINT32_MAX;
+    m_HasDedicatedComputeQueue  = m_VKQueueComputeIndex  != UINT32_MAX;
+
+    if (!m_HasDedicatedTransferQueue)
+        m_VKQueueTransferIndex = m_VKQueueGraphicsIndex;
+
+    if (!m_HasDedicatedComputeQueue)
+        m_VKQueueComputeIndex = m_VKQueueGraphicsIndex;
+
     // Create Vulkan Device
     // ----------------------
-    
-    if (window != nullptr)
-    {
-        if (m_VKQueueGraphicsIndex == UINT_MAX || m_VKQueuePresentIndex == UINT_MAX)
-            throw std::runtime_error("no graphics or present queue for the device.");
 
-        if (m_VKQueueGraphicsIndex != m_VKQueuePresentIndex)
-            throw std::runtime_error("no support for different graphics and present queue.");
-    }
-    else
-    {
-        if (m_VKQueueGraphicsIndex == UINT_MAX)
-            throw std::runtime_error("no graphics queue for the device.");
-    }
-        
     float queuePriority = 1.0f;
 
-    VkDeviceQueueCreateInfo queueCreateInfo ={};
-    queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueCreateInfo.queueFamilyIndex = m_VKQueueGraphicsIndex;
-    queueCreateInfo.queueCount       = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriority;
+    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+
+    for (uint32_t queueFamilyIndex : { m_VKQueueGraphicsIndex, m_VKQueuePresentIndex, m_VKQueueTransferIndex, m_VKQueueComputeIndex })
+    {
+        if (queueFamilyIndex == UINT32_MAX)
+            continue;
+
+        bool duplicate = false;
+
+        for (auto& queueCreateInfo : queueCreateInfos)
+            duplicate |= queueCreateInfo.queueFamilyIndex == queueFamilyIndex;
+
+        if (duplicate)
+            continue;
+
+        VkDeviceQueueCreateInfo queueCreateInfo = {};
+        queueCreateInfo.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueCreateInfo.queueFamilyIndex = queueFamilyIndex;
+        queueCreateInfo.queueCount       = 1;
+        queueCreateInfo.pQueuePriorities = &queuePriority;
+
+        queueCreateInfos.push_back(queueCreateInfo);
+    }
 
     // Specify the physical features to use. 
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(m_VKDevicePhysical, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
 
+    // Optional stages, only stages the device enables may be named when binding (or unbinding) shader objects.
+    deviceFeatures.tessellationShader = supportedFeatures.tessellationShader;
+    deviceFeatures.geometryShader     = supportedFeatures.geometryShader;
+
+    // For GpuProfiler.
+    deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+
+    m_GraphicsShaderStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    if (deviceFeatures.tessellationShader)
+        m_GraphicsShaderStages |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+
+    if (deviceFeatures.geometryShader)
+        m_GraphicsShaderStages |= VK_SHADER_STAGE_GEOMETRY_BIT;
+
+    m_EnabledFeatures = deviceFeatures;
+
     std::vector<const char*> enabledExtensions;
     {
         if (window != nullptr)
@@ -187,6 +265,8 @@ Device::Device(Window* window)
         enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
         enabledExtensions.push_back(VK_KHR_MAINTENANCE_2_EXTENSION_NAME);
         enabledExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME);
+        enabledExtensions.push_back(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME);
+        enabledExtensions.push_back(VK_KHR_MAINTENANCE_4_EXTENSION_NAME);
     }
 
 #if __APPLE__
@@ -220,18 +300,49 @@ Device::Device(Window* window)
     dynamicRenderingFeature.pNext            = &shaderObjectFeature;
     dynamicRenderingFeature.dynamicRendering = VK_TRUE;
 
-    // Setup to enable timeline semaphores.
+    // Setup to enable timeline semaphores, buffer device addresses and descriptor indexing.
+
+    VkPhysicalDeviceVulkan12Features supportedFeatures12 = {};
+    supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures2 = {};
+    supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures2.pNext = &supportedFeatures12;
+    vkGetPhysicalDeviceFeatures2(m_VKDevicePhysical, &supportedFeatures2);
 
     VkPhysicalDeviceVulkan12Features features12 =  {};
     features12.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
     features12.pNext             = &dynamicRenderingFeature;
-    features12.timelineSemaphore = VK_TRUE;
+
+    // Enables a required feature, or fails naming the one the device lacks.
+    #define REQUIRE_FEATURE_12(feature)                                        \
+        if (!supportedFeatures12.feature)                                      \
+            throw std::runtime_error("device does not support " #feature "."); \
+        features12.feature = VK_TRUE;
+
+    REQUIRE_FEATURE_12(timelineSemaphore);
+    REQUIRE_FEATURE_12(bufferDeviceAddress);
+    REQUIRE_FEATURE_12(drawIndirectCount);
+
+    // Bindless descriptor heap.
+    REQUIRE_FEATURE_12(descriptorIndexing);
+    REQUIRE_FEATURE_12(runtimeDescriptorArray);
+    REQUIRE_FEATURE_12(descriptorBindingPartiallyBound);
+    REQUIRE_FEATURE_12(descriptorBindingUpdateUnusedWhilePending);
+    REQUIRE_FEATURE_12(descriptorBindingSampledImageUpdateAfterBind);
+    REQUIRE_FEATURE_12(descriptorBindingStorageImageUpdateAfterBind);
+    REQUIRE_FEATURE_12(descriptorBindingStorageBufferUpdateAfterBind);
+    REQUIRE_FEATURE_12(shaderSampledImageArrayNonUniformIndexing);
+    REQUIRE_FEATURE_12(shaderStorageImageArrayNonUniformIndexing);
+    REQUIRE_FEATURE_12(shaderStorageBufferArrayNonUniformIndexing);
+
+    #undef REQUIRE_FEATURE_12
     
     VkDeviceCreateInfo deviceCreateInfo = {};
     deviceCreateInfo.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     deviceCreateInfo.pNext                   = &features12;
-    deviceCreateInfo.pQueueCreateInfos       = &queueCreateInfo;
-    deviceCreateInfo.queueCreateInfoCount    = 1;
+    deviceCreateInfo.pQueueCreateInfos       = queueCreateInfos.data();
+    deviceCreateInfo.queueCreateInfoCount    = (uint32_t)queueCreateInfos.size();
     deviceCreateInfo.pEnabledFeatures        = &deviceFeatures;
     deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
     deviceCreateInfo.enabledExtensionCount   = (uint32_t)enabledExtensions.size();
@@ -245,6 +356,9 @@ Device::Device(Window* window)
 
     vkGetDeviceQueue(m_VKDeviceLogical, m_VKQueueGraphicsIndex, 0, &m_VKQueueGraphics);
 
+    vkGetDeviceQueue(m_VKDeviceLogical, m_VKQueueTransferIndex, 0, &m_VKQueueTransfer);
+    vkGetDeviceQueue(m_VKDeviceLogical, m_VKQueueComputeIndex,  0, &m_VKQueueCompute);
+
     if (m_Window != nullptr)
         vkGetDeviceQueue(m_VKDeviceLogical, m_VKQueuePresentIndex,  0, &m_VKQueuePresent);
 
@@ -256,7 +370,7 @@ Device::Device(Window* window)
     vmaVulkanFunctions.vkGetDeviceProcAddr   = &vkGetDeviceProcAddr;
 
     VmaAllocatorCreateInfo allocatorCreateInfo = {};
-    allocatorCreateInfo.flags            = VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    allocatorCreateInfo.flags            = VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT | VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
     allocatorCreateInfo.vulkanApiVersion = VK_API_VERSION_1_2;
     allocatorCreateInfo.physicalDevice   = m_VKDevicePhysical;
     allocatorCreateInfo.device           = m_VKDeviceLogical;
@@ -275,6 +389,50 @@ Device::Device(Window* window)
     if (vkCreateCommandPool(m_VKDeviceLogical, &commandPoolInfo, nullptr, &m_VKCommandPool) != VK_SUCCESS)
         throw std::runtime_error("failed to create command pool.");
 
+    // Binding Model
+    // ---------------------
+
+    m_PushConstantRange = {};
+    m_PushConstantRange.stageFlags = VK_SHADER_STAGE_ALL;
+    m_PushConstantRange.offset     = 0;
+    m_PushConstantRange.size       = PUSH_CONSTANT_SIZE;
+
+    m_DescriptorHeap = std::make_unique<DescriptorHeap>(this);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount         = 1u;
+    pipelineLayoutInfo.pSetLayouts            = m_DescriptorHeap->GetSetLayout();
+    pipelineLayoutInfo.pushConstantRangeCount = 1u;
+    pipelineLayoutInfo.pPushConstantRanges    = &m_PushConstantRange;
+
+    if (vkCreatePipelineLayout(m_VKDeviceLogical, &pipelineLayoutInfo, nullptr, &m_VKPipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("failed to create pipeline layout.");
+
+    // Staging Ring
+    // ---------------------
+
+    m_StagingRing = std::make_unique<StagingRing>(this, STAGING_RING_SIZE);
+
+    m_FrameCommandPools = std::make_unique<FrameCommandPools>(this, m_VKQueueGraphicsIndex);
+
+    m_FrameAllocator = std::make_unique<FrameAllocator>(this, FRAME_ALLOCATOR_SIZE);
+
+    // Frame Timeline
+    // ---------------------
+
+    VkSemaphoreTypeCreateInfo timelineInfo = {};
+    timelineInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineInfo.initialValue  = 0;
+
+    VkSemaphoreCreateInfo timelineSemaphoreInfo = {};
+    timelineSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    timelineSemaphoreInfo.pNext = &timelineInfo;
+
+    if (vkCreateSemaphore(m_VKDeviceLogical, &timelineSemaphoreInfo, nullptr, &m_VKFrameTimeline) != VK_SUCCESS)
+        throw std::runtime_error("failed to create frame timeline semaphore.");
+
     // Create swap-chain
     // ---------------------
 
@@ -294,6 +452,7 @@ Device::Device(Window* window)
     GET_VK_FUNC(vkCmdSetPrimitiveTopologyEXT);
     GET_VK_FUNC(vkCreateShadersEXT);
     GET_VK_FUNC(vkDestroyShaderEXT);
+    GET_VK_FUNC(vkGetShaderBinaryDataEXT);
     GET_VK_FUNC(vkCmdSetColorWriteMaskEXT);
     GET_VK_FUNC(vkCmdSetPrimitiveRestartEnableEXT);
     GET_VK_FUNC(vkCmdSetColorBlendEnableEXT);
@@ -311,43 +470,257 @@ Device::Device(Window* window)
     GET_VK_FUNC(vkCmdSetScissorWithCountEXT);
     GET_VK_FUNC(vkCmdSetRasterizationSamplesEXT);
     GET_VK_FUNC(vkCmdSetSampleMaskEXT);
+    GET_VK_FUNC(vkCmdBlitImage2KHR);
+    GET_VK_FUNC(vkCmdWriteTimestamp2KHR);
+    GET_VK_FUNC(vkGetDeviceImageMemoryRequirementsKHR);
 }
 
 Device::~Device()
 {
-    vkDeviceWaitIdle(m_VKDeviceLogical);
+    {
+        std::lock_guard<std::mutex> lock(m_QueueMutex);
+        vkDeviceWaitIdle(m_VKDeviceLogical);
+    }
+
+    // Releases its buffers, before the drain below.
+    m_FrameAllocator.reset();
+
+    // Everything is idle, drain the deferred releases.
+    for (auto& release : m_DeferredReleases)
+        DestroyRelease(release);
+
+    m_DeferredReleases.clear();
+
+    m_StagingRing.reset();
+    m_FrameCommandPools.reset();
+    m_DescriptorHeap.reset();
 
     vmaDestroyAllocator(m_VMAAllocator);
 
     if (m_Window != nullptr)
         m_Window->ReleaseVulkanObjects(this);
 
+    vkDestroySemaphore(m_VKDeviceLogical, m_VKFrameTimeline, nullptr);
+    vkDestroyPipelineLayout(m_VKDeviceLogical, m_VKPipelineLayout, nullptr);
     vkDestroyCommandPool(m_VKDeviceLogical, m_VKCommandPool, nullptr);
     vkDestroyDevice(m_VKDeviceLogical, nullptr);
 }
 
-void Device::CreateShaders(const std::vector<Shader*>& shaders)
+static void DestroyShaderObjects(VkDevice device, std::vector<VkShaderEXT>& shaderObjects)
+{
+    for (auto& shaderObject : shaderObjects)
+    {
+        if (shaderObject != VK_NULL_HANDLE)
+            Device::vkDestroyShaderEXT(device, shaderObject, nullptr);
+
+        shaderObject = VK_NULL_HANDLE;
+    }
+}
+
+static void CreateShaderObjects(VkDevice device, const std::vector<Shader*>& shaders, VkShaderCreateFlagsEXT flags, ShaderCache* shaderCache)
+{
+    if (shaders.empty())
+        return;
+
+    std::vector<VkShaderCreateInfoEXT> spirvInfos(shaders.size());
+    std::vector<VkShaderCreateInfoEXT> createInfos(shaders.size());
+    std::vector<VkShaderEXT>           shaderObjects(shaders.size(), VK_NULL_HANDLE);
+
+    for (size_t i = 0; i < shaders.size(); ++i)
+    {
+        spirvInfos[i] = shaders[i]->GetInfo()->shader;
+        spirvInfos[i].flags |= flags;
+    }
+
+    createInfos = spirvInfos;
+
+    // Linked calls only come back from the cache when every stage of the set hits.
+    bool anyCached = shaderCache != nullptr && shaderCache->Find((uint32_t)shaders.size(), spirvInfos.data(), createInfos.data());
+
+    VkResult result = Device::vkCreateShadersEXT(device, (uint32_t)createInfos.size(), createInfos.data(), nullptr, shaderObjects.data());
+
+    if (result != VK_SUCCESS && anyCached)
+    {
+        // Incompatible or rejected binaries, rebuild the whole call from SPIR-V (linked sets must be created together).
+        DestroyShaderObjects(device, shaderObjects);
+
+        createInfos = spirvInfos;
+        result      = Device::vkCreateShadersEXT(device, (uint32_t)createInfos.size(), createInfos.data(), nullptr, shaderObjects.data());
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        // Don't leak whichever objects did get created.
+        DestroyShaderObjects(device, shaderObjects);
+
+        throw std::runtime_error("failed to create shader objects.");
+    }
+
+    for (size_t i = 0; i < shaders.size(); ++i)
+        shaders[i]->GetData()->shader = shaderObjects[i];
+
+    if (shaderCache != nullptr)
+        shaderCache->Store((uint32_t)shaders.size(), spirvInfos.data(), createInfos.data(), shaderObjects.data());
+}
+
+// Runs create(i) for every element of a batch (in parallel when a pool is given) and
+// reports every failure at once instead of stopping at the first one. A failing create(i)
+// cleans up after itself, the elements that succeeded are handed to release(i) before throwing.
+static void CreateBatch(TaskPool* taskPool, uint32_t count, const char* kind,
+                        const std::function<void(uint32_t)>& create, const std::function<void(uint32_t)>& release)
 {
+    std::mutex                                    errorMutex;
+    std::vector<std::pair<uint32_t, std::string>> errors;
+
+    auto task = [&](uint32_t i)
+    {
+        try
+        {
+            create(i);
+        }
+        catch (const std::exception& e)
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            errors.push_back({ i, e.what() });
+        }
+    };
+
+    if (taskPool != nullptr && count > 1)
+        taskPool->ParallelFor(count, task);
+    else
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            task(i);
+    }
+
+    if (errors.empty())
+        return;
+
+    std::sort(errors.begin(), errors.end());
+
+    for (uint32_t i = 0, error = 0; i < count; ++i)
+    {
+        if (error < errors.size() && errors[error].first == i)
+            ++error;
+        else
+            release(i);
+    }
+
+    std::string message = "failed to create " + std::to_string(errors.size()) + " of " + std::to_string(count) + " " + kind + ":";
+
+    for (auto& error : errors)
+        message += "\n    [" + std::to_string(error.first) + "] " + error.second;
+
+    throw std::runtime_error(message);
+}
+
+struct ShaderCall
+{
+    std::vector<Shader*>   shaders;
+    VkShaderCreateFlagsEXT flags;
+};
+
+// All shaders flagged for linking in a single call form one linked set, so each
+// chain gets its own call while the unlinked shaders can still be created together.
+static void GroupLinkedShaders(const std::vector<Shader*>& shaders, std::vector<Shader*>* unlinked, std::vector<ShaderCall>* calls)
+{
+    for (size_t i = 0; i < shaders.size();)
+    {
+        std::vector<Shader*> chain = { shaders[i] };
+        VkShaderStageFlags   stages = shaders[i]->GetInfo()->stages;
+
+        for (++i; i < shaders.size(); ++i)
+        {
+            VkShaderStageFlagBits stage = shaders[i]->GetInfo()->stages;
+
+            if (!(chain.back()->GetInfo()->shader.nextStage & stage) || (stages & stage))
+                break;
+
+            chain.push_back(shaders[i]);
+            stages |= stage;
+        }
+
+        if (chain.size() > 1)
+            calls->push_back({ std::move(chain), VK_SHADER_CREATE_LINK_STAGE_BIT_EXT });
+        else
+            unlinked->push_back(chain.front());
+    }
+}
+
+void Device::CreateShaders(const std::vector<Shader*>& shaders, bool linkStages)
+{
+    CPU_TRACE_SCOPE("Device::CreateShaders");
+
+    for (auto& shader : shaders)
+    {
+        if (shader->GetInfo()->shader.pCode == nullptr)
+            throw std::runtime_error("shader byte code was already released.");
+    }
+
+    // Every shader shares the device's layout, so any of them can be bound together.
     for (auto& shader : shaders)
     {
-        // TODO: Do this in one native call. 
-        Device::vkCreateShadersEXT(m_VKDeviceLogical, 1u, &shader->GetInfo()->shader, nullptr, &shader->GetData()->shader);
+        shader->GetInfo()->shader.setLayoutCount         = 1u;
+        shader->GetInfo()->shader.pSetLayouts            = m_DescriptorHeap->GetSetLayout();
+        shader->GetInfo()->shader.pushConstantRangeCount = 1u;
+        shader->GetInfo()->shader.pPushConstantRanges    = &m_PushConstantRange;
+    }
+
+    std::vector<Shader*>    unlinked;
+    std::vector<ShaderCall> calls;
+
+    if (linkStages)
+        GroupLinkedShaders(shaders, &unlinked, &calls);
+    else
+        unlinked = shaders;
+
+    // Unlinked shaders take one native call per thread, compilation being the expensive part.
+    size_t threadCount = m_TaskPool != nullptr ? m_TaskPool->GetThreadCount() : 1u;
+    size_t chunkCount  = std::min(threadCount, unlinked.size());
+
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        auto begin = unlinked.begin() + (unlinked.size() *  chunk)      / chunkCount;
+        auto end   = unlinked.begin() + (unlinked.size() * (chunk + 1)) / chunkCount;
+
+        calls.push_back({ std::vector<Shader*>(begin, end), 0x0 });
     }
+
+    CreateBatch(m_TaskPool.get(), (uint32_t)calls.size(), "shader batches", [&](uint32_t i)
+    {
+        CreateShaderObjects(m_VKDeviceLogical, calls[i].shaders, calls[i].flags, m_ShaderCache);
+    },
+    [&](uint32_t i)
+    {
+        ReleaseShaders(calls[i].shaders);
+    });
+
+    // The byte code isn't needed past creation, unmap it right away.
+    for (auto& shader : shaders)
+        shader->ReleaseByteCode();
 }
 
 void Device::ReleaseShaders(const std::vector<Shader*>& shaders)
 {
     for (auto& shader : shaders)
     {
-        free(shader->GetData()->spirvByteCode);
-        Device::vkDestroyShaderEXT(m_VKDeviceLogical, shader->GetData()->shader, nullptr);
+        DeferredRelease release = {};
+        release.shader = shader->GetData()->shader;
+
+        DeferRelease(release);
+
+        shader->GetData()->shader = VK_NULL_HANDLE;
     }
 }
 
 void Device::CreateBuffers(const std::vector<Buffer*>& buffers)
 {
-    for (auto& buffer : buffers)
+    CPU_TRACE_SCOPE("Device::CreateBuffers");
+
+    CreateBatch(m_TaskPool.get(), (uint32_t)buffers.size(), "buffers", [&](uint32_t i)
     {
+        auto buffer = buffers[i];
+
         auto hr = vmaCreateBuffer(m_VMAAllocator, 
                             &buffer->GetInfo()->buffer, 
                             &buffer->GetInfo()->allocation, 
@@ -361,24 +734,67 @@ void Device::CreateBuffers(const std::vector<Buffer*>& buffers)
         // Patch in the created buffer.
         buffer->GetInfo()->view.buffer = buffer->GetData()->buffer;
 
-        vkCreateBufferView(m_VKDeviceLogical, &buffer->GetInfo()->view, nullptr, &buffer->GetData()->view);
-    }
+        VkBufferDeviceAddressInfo addressInfo = {};
+        addressInfo.sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        addressInfo.buffer = buffer->GetData()->buffer;
 
+        buffer->GetData()->address = vkGetBufferDeviceAddress(m_VKDeviceLogical, &addressInfo);
+
+        // The heap may be full.
+        try
+        {
+            m_DescriptorHeap->Register(buffer);
+        }
+        catch (...)
+        {
+            ReleaseBuffers({ buffer });
+            throw;
+        }
+
+        *buffer->GetState() = {};
+
+        // Views only exist for texel buffers.
+        if (!(buffer->GetInfo()->buffer.usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)))
+            return;
+
+        if (vkCreateBufferView(m_VKDeviceLogical, &buffer->GetInfo()->view, nullptr, &buffer->GetData()->view) != VK_SUCCESS)
+        {
+            buffer->GetData()->view = VK_NULL_HANDLE;
+            ReleaseBuffers({ buffer });
+            throw std::runtime_error("Failed to create buffer view.");
+        }
+    },
+    [&](uint32_t i)
+    {
+        ReleaseBuffers({ buffers[i] });
+    });
 }
 
 void Device::ReleaseBuffers(const std::vector<Buffer*>& buffers)
 {
     for (auto& buffer : buffers)
     {
-        vmaDestroyBuffer(m_VMAAllocator, buffer->GetData()->buffer, buffer->GetData()->allocation);
-        vkDestroyBufferView(m_VKDeviceLogical, buffer->GetData()->view, nullptr);
+        DeferredRelease release = {};
+        release.buffer     = buffer->GetData()->buffer;
+        release.bufferView = buffer->GetData()->view;
+        release.allocation = buffer->GetData()->allocation;
+
+        release.storageBufferIndex = buffer->GetData()->storageIndex;
+
+        DeferRelease(release);
+
+        *buffer->GetData() = {};
     }
 }
 
 void Device::CreateImages(const std::vector<Image*>& images)
 {
-    for (auto& image : images)
+    CPU_TRACE_SCOPE("Device::CreateImages");
+
+    CreateBatch(m_TaskPool.get(), (uint32_t)images.size(), "images", [&](uint32_t i)
     {
+        auto image = images[i];
+
         auto hr = vmaCreateImage(m_VMAAllocator, 
                     &image->GetInfo()->image, 
                     &image->GetInfo()->allocation, 
@@ -391,60 +807,223 @@ void Device::CreateImages(const std::vector<Image*>& images)
         // Patch in the created image.
         image->GetInfo()->view.image = image->GetData()->image;
 
-        vkCreateImageView(m_VKDeviceLogical, &image->GetInfo()->view, nullptr, &image->GetData()->view);
-    }
+        if (vkCreateImageView(m_VKDeviceLogical, &image->GetInfo()->view, nullptr, &image->GetData()->view) != VK_SUCCESS)
+        {
+            image->GetData()->view = VK_NULL_HANDLE;
+            ReleaseImages({ image });
+            throw std::runtime_error("Failed to create image view.");
+        }
+
+        if (image->GetInfo()->levelViews)
+        {
+            auto levelViewInfo = image->GetInfo()->view;
+            levelViewInfo.subresourceRange.levelCount = 1;
+
+            image->GetData()->levelViews.resize(image->GetInfo()->image.mipLevels);
+
+            for (uint32_t level = 0; level < image->GetInfo()->image.mipLevels; ++level)
+            {
+                levelViewInfo.subresourceRange.baseMipLevel = level;
+
+                if (vkCreateImageView(m_VKDeviceLogical, &levelViewInfo, nullptr, &image->GetData()->levelViews[level]) != VK_SUCCESS)
+                {
+                    image->GetData()->levelViews[level] = VK_NULL_HANDLE;
+                    ReleaseImages({ image });
+                    throw std::runtime_error("Failed to create image level view.");
+                }
+            }
+        }
+
+        image->ResetState();
+
+        // The heap may be full, an index allocated before that is freed with the image.
+        try
+        {
+            m_DescriptorHeap->Register(image);
+        }
+        catch (...)
+        {
+            ReleaseImages({ image });
+            throw;
+        }
+    },
+    [&](uint32_t i)
+    {
+        ReleaseImages({ images[i] });
+    });
 }
 
 void Device::ReleaseImages(const std::vector<Image*>& images)
 {
     for (auto& image : images)
     {
-        vmaDestroyImage(m_VMAAllocator, image->GetData()->image, image->GetData()->allocation);
-        vkDestroyImageView(m_VKDeviceLogical, image->GetData()->view, nullptr);
+        DeferredRelease release = {};
+        release.image      = image->GetData()->image;
+        release.imageView  = image->GetData()->view;
+        release.allocation = image->GetData()->allocation;
+
+        release.sampledIndex      = image->GetData()->sampledIndex;
+        release.storageImageIndex = image->GetData()->storageIndex;
+
+        DeferRelease(release);
+
+        for (auto levelView : image->GetData()->levelViews)
+        {
+            DeferredRelease levelRelease = {};
+            levelRelease.imageView = levelView;
+
+            DeferRelease(levelRelease);
+        }
+
+        *image->GetData() = {};
     }
 }
 
-void Device::SetDefaultRenderState(VkCommandBuffer commandBuffer)
+void Device::UpdateImageViews(const std::vector<Image*>& images)
 {
-    static VkColorComponentFlags s_DefaultWriteMask =   VK_COLOR_COMPONENT_R_BIT | 
-                                                        VK_COLOR_COMPONENT_G_BIT | 
-                                                        VK_COLOR_COMPONENT_B_BIT | 
-                                                        VK_COLOR_COMPONENT_A_BIT;
+    for (auto& image : images)
+    {
+        DeferredRelease release = {};
+        release.imageView         = image->GetData()->view;
+        release.sampledIndex      = image->GetData()->sampledIndex;
+        release.storageImageIndex = image->GetData()->storageIndex;
+
+        DeferRelease(release);
+
+        image->GetData()->sampledIndex = 0;
+        image->GetData()->storageIndex = 0;
+
+        if (vkCreateImageView(m_VKDeviceLogical, &image->GetInfo()->view, nullptr, &image->GetData()->view) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create image view.");
 
-    static VkColorBlendEquationEXT s_DefaultColorBlend = 
+        m_DescriptorHeap->Register(image);
+    }
+}
+
+void Device::ReleaseAllocations(const std::vector<VmaAllocation>& allocations)
+{
+    for (auto& allocation : allocations)
     {
-        // Color
-        VK_BLEND_FACTOR_ONE,
-        VK_BLEND_FACTOR_ZERO,
-        VK_BLEND_OP_ADD,
-
-        // Alpha
-        VK_BLEND_FACTOR_ONE,
-        VK_BLEND_FACTOR_ZERO,
-        VK_BLEND_OP_ADD,
-    };
+        DeferredRelease release = {};
+        release.allocation = allocation;
+
+        DeferRelease(release);
+    }
+}
+
+void Device::SetCreationThreadCount(uint32_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    if (threadCount == 1)
+        m_TaskPool.reset();
+    else
+        m_TaskPool = std::make_unique<TaskPool>(threadCount);
+}
+
+void Device::FlushUploads()
+{
+    m_StagingRing->Flush();
+}
+
+void Device::BeginFrame(uint32_t frameIndex)
+{
+    m_FrameCommandPools->Reset(frameIndex);
+    m_FrameAllocator->Reset(frameIndex);
+
+    CollectReleases();
+}
+
+void Device::DeferRelease(DeferredRelease release)
+{
+    // The frame currently being recorded (GetAcquiredFrame()) may still reference the object. Keying on the one
+    // after it also covers releases made between frames: the next frame is submitted after any staging or other
+    // work already on the graphics queue.
+    release.frameNumber = GetAcquiredFrame() + 1;
+
+    std::lock_guard<std::mutex> lock(m_ReleaseMutex);
+    m_DeferredReleases.push_back(release);
+}
+
+void Device::CollectReleases()
+{
+    std::lock_guard<std::mutex> lock(m_ReleaseMutex);
+
+    if (m_DeferredReleases.empty())
+        return;
+
+    uint64_t completedFrame = GetCompletedFrame();
+
+    while (!m_DeferredReleases.empty() && m_DeferredReleases.front().frameNumber <= completedFrame)
+    {
+        DestroyRelease(m_DeferredReleases.front());
+        m_DeferredReleases.pop_front();
+    }
+}
+
+void Device::DestroyRelease(const DeferredRelease& release)
+{
+    if (release.bufferView != VK_NULL_HANDLE)
+        vkDestroyBufferView(m_VKDeviceLogical, release.bufferView, nullptr);
+
+    if (release.imageView != VK_NULL_HANDLE)
+        vkDestroyImageView(m_VKDeviceLogical, release.imageView, nullptr);
+
+    if (release.shader != VK_NULL_HANDLE)
+        Device::vkDestroyShaderEXT(m_VKDeviceLogical, release.shader, nullptr);
+
+    m_DescriptorHeap->Free(DescriptorHeap::SampledImages,  release.sampledIndex);
+    m_DescriptorHeap->Free(DescriptorHeap::StorageImages,  release.storageImageIndex);
+    m_DescriptorHeap->Free(DescriptorHeap::StorageBuffers, release.storageBufferIndex);
+
+    // VMA handles a null allocation (and a null buffer / image).
+    if (release.buffer != VK_NULL_HANDLE)
+        vmaDestroyBuffer(m_VMAAllocator, release.buffer, release.allocation);
+    else if (release.image != VK_NULL_HANDLE)
+        vmaDestroyImage(m_VMAAllocator, release.image, release.allocation);
+    else if (release.allocation != VK_NULL_HANDLE)
+        vmaFreeMemory(m_VMAAllocator, release.allocation);
+}
+
+uint64_t Device::GetCompletedFrame() const
+{
+    uint64_t completedFrame = 0;
+    vkGetSemaphoreCounterValue(m_VKDeviceLogical, m_VKFrameTimeline, &completedFrame);
 
-    static VkBool32     s_DefaultBlendEnable = VK_FALSE;
-    static VkViewport   s_DefaultViewport    = { 0, 0, 64, 64, 0.0, 1.0 };
-    static VkRect2D     s_DefaultScissor     = { 0, 0, 64, 64 };
-    static VkSampleMask s_DefaultSampleMask  = 0xFFFFFFFF;
-
-    Device::vkCmdSetColorBlendEnableEXT       (commandBuffer, 0u, 1u, &s_DefaultBlendEnable);
-    Device::vkCmdSetColorWriteMaskEXT         (commandBuffer, 0u, 1u, &s_DefaultWriteMask);
-    Device::vkCmdSetColorBlendEquationEXT     (commandBuffer, 0u, 1u, &s_DefaultColorBlend);
-    Device::vkCmdSetViewportWithCountEXT      (commandBuffer, 1u, &s_DefaultViewport);
-    Device::vkCmdSetScissorWithCountEXT       (commandBuffer, 1u, &s_DefaultScissor);
-    Device::vkCmdSetPrimitiveRestartEnableEXT (commandBuffer, VK_FALSE);
-    Device::vkCmdSetRasterizerDiscardEnableEXT(commandBuffer, VK_FALSE);
-    Device::vkCmdSetAlphaToCoverageEnableEXT  (commandBuffer, VK_FALSE);
-    Device::vkCmdSetStencilTestEnableEXT      (commandBuffer, VK_FALSE);
-    Device::vkCmdSetDepthTestEnableEXT        (commandBuffer, VK_FALSE);
-    Device::vkCmdSetDepthBiasEnableEXT        (commandBuffer, VK_FALSE);
-    Device::vkCmdSetDepthWriteEnableEXT       (commandBuffer, VK_FALSE);
-    Device::vkCmdSetRasterizationSamplesEXT   (commandBuffer, VK_SAMPLE_COUNT_1_BIT);
-    Device::vkCmdSetSampleMaskEXT             (commandBuffer, VK_SAMPLE_COUNT_1_BIT, &s_DefaultSampleMask);
-    Device::vkCmdSetFrontFaceEXT              (commandBuffer, VK_FRONT_FACE_CLOCKWISE);
-    Device::vkCmdSetPolygonModeEXT            (commandBuffer, VK_POLYGON_MODE_FILL);
-    Device::vkCmdSetCullModeEXT               (commandBuffer, VK_CULL_MODE_BACK_BIT);
-    Device::vkCmdSetPrimitiveTopologyEXT      (commandBuffer, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+    return completedFrame;
+}
+
+void Device::WaitForFrame(uint64_t frameNumber) const
+{
+    CPU_TRACE_SCOPE("Device::WaitForFrame");
+
+    VkSemaphoreWaitInfo waitInfo = {};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1u;
+    waitInfo.pSemaphores    = &m_VKFrameTimeline;
+    waitInfo.pValues        = &frameNumber;
+
+    vkWaitSemaphores(m_VKDeviceLogical, &waitInfo, UINT64_MAX);
+}
+
+uint64_t Device::AcquireFrameNumber()
+{
+    return m_AcquiredFrame.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+void Device::PushConstants(VkCommandBuffer commandBuffer, const void* data, uint32_t size, uint32_t offset) const
+{
+    if (offset + size > PUSH_CONSTANT_SIZE)
+        throw std::runtime_error("push constants exceed PUSH_CONSTANT_SIZE.");
+
+    vkCmdPushConstants(commandBuffer, m_VKPipelineLayout, VK_SHADER_STAGE_ALL, offset, size, data);
+}
+
+void Device::SetDefaultRenderState(VkCommandBuffer commandBuffer)
+{
+    // A fresh cache knows nothing about the command buffer, so every state is emitted.
+    StateCache stateCache;
+    stateCache.Begin(commandBuffer);
+    stateCache.SetState(RenderState::Default());
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include <VulkanWrappers/DrawBatcher.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Shader.h>
+#include <VulkanWrappers/StateCache.h>
+#include <VulkanWrappers/FrameAllocator.h>
+#include <VulkanWrappers/BarrierBatch.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace VulkanWrappers;
+
+static_assert(sizeof(DrawBatcher::DrawRecord) == 48, "DrawRecord must match its std430 layout.");
+
+static const VkBufferUsageFlags s_CulledUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT  |
+                                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+DrawBatcher::DrawBatcher(Device* device, uint32_t maxDraws)
+    : m_Device(device), m_MaxDraws(maxDraws), m_Records(), m_Counts(), m_Culled(false), m_CullParameters()
+{
+    // There are never more batches than draws.
+    m_CulledRecords = Buffer(sizeof(DrawRecord) * maxDraws, s_CulledUsage, 0x0);
+    m_CulledCounts  = Buffer(sizeof(uint32_t)   * maxDraws, s_CulledUsage, 0x0);
+
+    device->CreateBuffers({ &m_CulledRecords, &m_CulledCounts });
+}
+
+DrawBatcher::~DrawBatcher()
+{
+    m_Device->ReleaseBuffers({ &m_CulledRecords, &m_CulledCounts });
+}
+
+void DrawBatcher::Add(const ShaderProgram* program, const RenderState* state, const VkDrawIndexedIndirectCommand& command, const float* bounds)
+{
+    if (m_Draws.size() == m_MaxDraws)
+        throw std::runtime_error("draw batcher is full.");
+
+    PendingDraw draw = {};
+    draw.program        = program;
+    draw.state          = state;
+    draw.record.command = command;
+
+    if (bounds != nullptr)
+        memcpy(draw.record.bounds, bounds, sizeof(draw.record.bounds));
+
+    m_Draws.push_back(draw);
+}
+
+void DrawBatcher::Build()
+{
+    m_Batches.clear();
+    m_Culled = false;
+
+    m_Order.resize(m_Draws.size());
+
+    for (uint32_t i = 0; i < m_Order.size(); ++i)
+        m_Order[i] = i;
+
+    // Program changes cost more than state changes, so they lead the key. Stable to keep submission order in a batch.
+    std::stable_sort(m_Order.begin(), m_Order.end(), [&](uint32_t a, uint32_t b)
+    {
+        if (m_Draws[a].program != m_Draws[b].program)
+            return m_Draws[a].program < m_Draws[b].program;
+
+        return m_Draws[a].state < m_Draws[b].state;
+    });
+
+    for (uint32_t i = 0; i < m_Order.size(); ++i)
+    {
+        auto& draw = m_Draws[m_Order[i]];
+
+        if (m_Batches.empty() || m_Batches.back().program != draw.program || m_Batches.back().state != draw.state)
+            m_Batches.push_back({ draw.program, draw.state, i, 0 });
+
+        m_Batches.back().count++;
+    }
+
+    if (m_Draws.empty())
+        return;
+
+    auto frameAllocator = m_Device->GetFrameAllocator();
+
+    m_Records = frameAllocator->Allocate(sizeof(DrawRecord) * m_Draws.size());
+    m_Counts  = frameAllocator->Allocate(sizeof(uint32_t)   * m_Batches.size());
+
+    auto records = static_cast<DrawRecord*>(m_Records.mapped);
+    auto counts  = static_cast<uint32_t*>(m_Counts.mapped);
+
+    for (uint32_t batchIndex = 0; batchIndex < m_Batches.size(); ++batchIndex)
+    {
+        auto& batch = m_Batches[batchIndex];
+
+        for (uint32_t i = batch.first; i < batch.first + batch.count; ++i)
+        {
+            auto record = m_Draws[m_Order[i]].record;
+            record.batch       = batchIndex;
+            record.batchOffset = batch.first;
+
+            records[i] = record;
+        }
+
+        counts[batchIndex] = batch.count;
+    }
+
+    m_CullParameters.records       = m_Records.address;
+    m_CullParameters.culledRecords = m_CulledRecords.GetData()->address;
+    m_CullParameters.culledCounts  = m_CulledCounts.GetData()->address;
+    m_CullParameters.drawCount     = (uint32_t)m_Draws.size();
+}
+
+void DrawBatcher::PrepareCull(VkCommandBuffer commandBuffer)
+{
+    if (m_Batches.empty())
+        return;
+
+    {
+        // The previous frame's draw may still read the counts.
+        BarrierBatch barriers(commandBuffer);
+        barriers.Transition(&m_CulledCounts, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    }
+
+    vkCmdFillBuffer(commandBuffer, m_CulledCounts.GetData()->buffer, 0, sizeof(uint32_t) * m_Batches.size(), 0u);
+
+    BarrierBatch barriers(commandBuffer);
+    barriers.Transition(&m_CulledCounts,  VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+    barriers.Transition(&m_CulledRecords, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    m_Culled = true;
+}
+
+void DrawBatcher::FinishCull(VkCommandBuffer commandBuffer)
+{
+    if (m_Batches.empty() || !m_Culled)
+        return;
+
+    BarrierBatch barriers(commandBuffer);
+    barriers.Transition(&m_CulledRecords, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+    barriers.Transition(&m_CulledCounts,  VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+}
+
+void DrawBatcher::Draw(StateCache* stateCache)
+{
+    if (m_Batches.empty())
+        return;
+
+    auto commandBuffer = stateCache->GetCommandBuffer();
+
+    VkBuffer     recordBuffer = m_Records.buffer->GetData()->buffer;
+    VkDeviceSize recordOffset = m_Records.offset;
+    VkBuffer     countBuffer  = m_Counts.buffer->GetData()->buffer;
+    VkDeviceSize countOffset  = m_Counts.offset;
+
+    if (m_Culled)
+    {
+        recordBuffer = m_CulledRecords.GetData()->buffer;
+        recordOffset = 0;
+        countBuffer  = m_CulledCounts.GetData()->buffer;
+        countOffset  = 0;
+    }
+
+    for (uint32_t batchIndex = 0; batchIndex < m_Batches.size(); ++batchIndex)
+    {
+        auto& batch = m_Batches[batchIndex];
+
+        ShaderProgram::Bind(stateCache, *batch.program);
+        stateCache->SetState(*batch.state);
+
+        vkCmdDrawIndexedIndirectCount(commandBuffer,
+                                      recordBuffer, recordOffset + sizeof(DrawRecord) * batch.first,
+                                      countBuffer,  countOffset  + sizeof(uint32_t)   * batchIndex,
+                                      batch.count, sizeof(DrawRecord));
+    }
+}
+
+void DrawBatcher::Reset()
+{
+    m_Draws.clear();
+    m_Batches.clear();
+
+    m_Culled = false;
+}
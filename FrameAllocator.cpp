@@ -0,0 +1,88 @@
+#include <VulkanWrappers/FrameAllocator.h>
+#include <VulkanWrappers/Device.h>
+
+#include <algorithm>
+
+using namespace VulkanWrappers;
+
+static const VkBufferUsageFlags s_FrameAllocatorUsage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT  |
+                                                        VK_BUFFER_USAGE_INDEX_BUFFER_BIT   |
+                                                        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+FrameAllocator::FrameAllocator(Device* device, VkDeviceSize sizePerFrame)
+    : m_Device(device), m_Capacity(sizePerFrame), m_MinAlignment(16), m_FrameIndex(0), m_Head(0)
+{
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(device->GetPhysical(), &properties);
+
+    m_MinAlignment = std::max(m_MinAlignment, properties.limits.minUniformBufferOffsetAlignment);
+    m_MinAlignment = std::max(m_MinAlignment, properties.limits.minStorageBufferOffsetAlignment);
+
+    std::vector<Buffer*> buffers;
+
+    for (auto& frame : m_Frames)
+    {
+        frame.buffer = Buffer(sizePerFrame, s_FrameAllocatorUsage, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+        // Writes through the mapped pointer must never need a flush.
+        frame.buffer.GetInfo()->allocation.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        buffers.push_back(&frame.buffer);
+    }
+
+    device->CreateBuffers(buffers);
+
+    for (auto& frame : m_Frames)
+    {
+        VmaAllocationInfo allocationInfo = {};
+        vmaGetAllocationInfo(device->GetAllocator(), frame.buffer.GetData()->allocation, &allocationInfo);
+
+        frame.mapped = allocationInfo.pMappedData;
+    }
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    std::vector<Buffer*> buffers;
+
+    for (auto& frame : m_Frames)
+        buffers.push_back(&frame.buffer);
+
+    // Released like any storage buffer, so their descriptor heap indices are freed too.
+    m_Device->ReleaseBuffers(buffers);
+}
+
+BufferSlice FrameAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    alignment = std::max(alignment, m_MinAlignment);
+
+    // The head always stays aligned to the minimum, so only larger alignments need padding.
+    VkDeviceSize paddedSize = ((size + m_MinAlignment - 1) & ~(m_MinAlignment - 1)) + (alignment - m_MinAlignment);
+
+    VkDeviceSize head   = m_Head.fetch_add(paddedSize, std::memory_order_relaxed);
+    VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+
+    if (offset + size > m_Capacity)
+        throw std::runtime_error("frame allocator is out of memory.");
+
+    auto& frame = m_Frames[m_FrameIndex];
+
+    BufferSlice slice = {};
+    slice.buffer  = &frame.buffer;
+    slice.offset  = offset;
+    slice.size    = size;
+    slice.mapped  = static_cast<uint8_t*>(frame.mapped) + offset;
+    slice.address = frame.buffer.GetData()->address + offset;
+    slice.block   = m_FrameIndex;
+
+    return slice;
+}
+
+void FrameAllocator::Reset(uint32_t frameIndex)
+{
+    m_FrameIndex = frameIndex;
+    m_Head.store(0, std::memory_order_relaxed);
+}
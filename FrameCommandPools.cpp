@@ -0,0 +1,137 @@
+#include <VulkanWrappers/FrameCommandPools.h>
+#include <VulkanWrappers/Device.h>
+
+#include <atomic>
+
+using namespace VulkanWrappers;
+
+// Identifies pool sets for the per-thread lookup cache (addresses can be reused).
+static std::atomic<uint64_t> s_NextPoolsId(1);
+
+struct ThreadPoolsCache
+{
+    uint64_t owner;
+    void*    pools;
+};
+
+static thread_local ThreadPoolsCache s_ThreadPoolsCache = { 0, nullptr };
+
+FrameCommandPools::FrameCommandPools(const Device* device, uint32_t queueFamilyIndex)
+    : m_Device(device), m_QueueFamilyIndex(queueFamilyIndex), m_Id(s_NextPoolsId.fetch_add(1))
+{}
+
+FrameCommandPools::~FrameCommandPools()
+{
+    for (auto& thread : m_Threads)
+    {
+        // Destroying a pool frees its command buffers too.
+        for (auto& frame : thread->frames)
+            vkDestroyCommandPool(m_Device->GetLogical(), frame.pool, nullptr);
+    }
+}
+
+FrameCommandPools::ThreadPools* FrameCommandPools::GetThreadPools()
+{
+    if (s_ThreadPoolsCache.owner == m_Id)
+        return static_cast<ThreadPools*>(s_ThreadPoolsCache.pools);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ThreadPools* threadPools = nullptr;
+
+    for (auto& thread : m_Threads)
+    {
+        if (thread->threadId == std::this_thread::get_id())
+            threadPools = thread.get();
+    }
+
+    // First time this thread records, give it its own pools.
+    if (threadPools == nullptr)
+    {
+        auto newPools = std::make_unique<ThreadPools>();
+        newPools->threadId = std::this_thread::get_id();
+
+        for (auto& frame : newPools->frames)
+        {
+            VkCommandPoolCreateInfo commandPoolInfo = {};
+            commandPoolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            commandPoolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            commandPoolInfo.queueFamilyIndex = m_QueueFamilyIndex;
+
+            frame = {};
+
+            if (vkCreateCommandPool(m_Device->GetLogical(), &commandPoolInfo, nullptr, &frame.pool) != VK_SUCCESS)
+                throw std::runtime_error("failed to create frame command pool.");
+        }
+
+        threadPools = newPools.get();
+        m_Threads.push_back(std::move(newPools));
+    }
+
+    s_ThreadPoolsCache = { m_Id, threadPools };
+
+    return threadPools;
+}
+
+void FrameCommandPools::Reset(uint32_t frameIndex)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (auto& thread : m_Threads)
+    {
+        auto& frame = thread->frames[frameIndex];
+
+        if (frame.usedPrimaries == 0 && frame.usedSecondaries == 0)
+            continue;
+
+        vkResetCommandPool(m_Device->GetLogical(), frame.pool, 0x0);
+
+        frame.usedPrimaries   = 0;
+        frame.usedSecondaries = 0;
+    }
+
+    m_Queued[frameIndex].clear();
+}
+
+VkCommandBuffer FrameCommandPools::Allocate(uint32_t frameIndex, VkCommandBufferLevel level)
+{
+    auto& frame = GetThreadPools()->frames[frameIndex];
+
+    bool primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+    auto& commandBuffers = primary ? frame.primaries     : frame.secondaries;
+    auto& used           = primary ? frame.usedPrimaries : frame.usedSecondaries;
+
+    if (used == commandBuffers.size())
+    {
+        VkCommandBufferAllocateInfo commandAllocateInfo = {};
+        commandAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandAllocateInfo.commandPool        = frame.pool;
+        commandAllocateInfo.level              = level;
+        commandAllocateInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+
+        if (vkAllocateCommandBuffers(m_Device->GetLogical(), &commandAllocateInfo, &commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate command buffer.");
+
+        commandBuffers.push_back(commandBuffer);
+    }
+
+    return commandBuffers[used++];
+}
+
+void FrameCommandPools::Enqueue(uint32_t frameIndex, VkCommandBuffer commandBuffer)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Queued[frameIndex].push_back(commandBuffer);
+}
+
+void FrameCommandPools::TakeQueued(uint32_t frameIndex, std::vector<VkCommandBuffer>* commandBuffers)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    commandBuffers->insert(commandBuffers->end(), m_Queued[frameIndex].begin(), m_Queued[frameIndex].end());
+    m_Queued[frameIndex].clear();
+}
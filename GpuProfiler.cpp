@@ -0,0 +1,211 @@
+#include <VulkanWrappers/GpuProfiler.h>
+#include <VulkanWrappers/Device.h>
+
+#include <string.h>
+
+using namespace VulkanWrappers;
+
+// Queried statistics, results come back in bit order (the order of PipelineStatistics).
+static const VkQueryPipelineStatisticFlags s_StatisticFlags = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT                 |
+                                                              VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT               |
+                                                              VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT               |
+                                                              VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT                    |
+                                                              VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT                     |
+                                                              VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT             |
+                                                              VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+static const uint32_t s_StatisticCount = sizeof(GpuProfiler::PipelineStatistics) / sizeof(uint64_t);
+
+GpuProfiler::GpuProfiler(Device* device, uint32_t maxScopes, bool pipelineStatistics)
+    : m_Device(device), m_MaxScopes(maxScopes), m_PipelineStatistics(pipelineStatistics), m_Current(nullptr), m_ResultsFrame(0)
+{
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(device->GetPhysical(), &properties);
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device->GetPhysical(), &familyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device->GetPhysical(), &familyCount, families.data());
+
+    uint32_t validBits = families[device->GetGraphicsQueueFamily()].timestampValidBits;
+
+    if (validBits == 0)
+        throw std::runtime_error("graphics queue does not support timestamps.");
+
+    if (pipelineStatistics && !device->GetEnabledFeatures().pipelineStatisticsQuery)
+        throw std::runtime_error("device does not support pipeline statistics queries.");
+
+    m_TimestampPeriod = properties.limits.timestampPeriod;
+    m_TimestampMask   = validBits == 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+    for (auto& queries : m_Frames)
+    {
+        queries = {};
+
+        VkQueryPoolCreateInfo poolInfo = {};
+        poolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = maxScopes * 2;
+
+        if (vkCreateQueryPool(device->GetLogical(), &poolInfo, nullptr, &queries.timestamps) != VK_SUCCESS)
+            throw std::runtime_error("failed to create timestamp query pool.");
+
+        if (!pipelineStatistics)
+            continue;
+
+        poolInfo.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        poolInfo.queryCount         = maxScopes;
+        poolInfo.pipelineStatistics = s_StatisticFlags;
+
+        if (vkCreateQueryPool(device->GetLogical(), &poolInfo, nullptr, &queries.statistics) != VK_SUCCESS)
+            throw std::runtime_error("failed to create pipeline statistics query pool.");
+    }
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    if (m_Device->GetGpuProfiler() == this)
+        m_Device->SetGpuProfiler(nullptr);
+
+    // The pools may still be written by frames in flight.
+    {
+        std::lock_guard<std::mutex> lock(m_Device->GetQueueMutex());
+        vkDeviceWaitIdle(m_Device->GetLogical());
+    }
+
+    for (auto& queries : m_Frames)
+    {
+        vkDestroyQueryPool(m_Device->GetLogical(), queries.timestamps, nullptr);
+
+        if (queries.statistics != VK_NULL_HANDLE)
+            vkDestroyQueryPool(m_Device->GetLogical(), queries.statistics, nullptr);
+    }
+}
+
+void GpuProfiler::BeginFrame(const Frame* frame)
+{
+    auto& queries = m_Frames[frame->index];
+
+    // The frame loop waited for this slot to retire, its results are (almost always) there without stalling.
+    if (queries.submitted)
+        ReadResults(queries);
+
+    vkCmdResetQueryPool(frame->commandBuffer, queries.timestamps, 0, m_MaxScopes * 2);
+
+    if (queries.statistics != VK_NULL_HANDLE)
+        vkCmdResetQueryPool(frame->commandBuffer, queries.statistics, 0, m_MaxScopes);
+
+    queries.scopes.clear();
+    queries.statisticsCount = 0;
+    queries.frameNumber     = frame->number;
+    queries.submitted       = false;
+
+    m_Current = &queries;
+    m_Stack.clear();
+
+    BeginScope(frame->commandBuffer, "Frame");
+}
+
+void GpuProfiler::EndFrame(const Frame* frame)
+{
+    // Close whatever the caller left open along with the root.
+    while (!m_Stack.empty())
+        EndScope(frame->commandBuffer, m_Stack.back());
+
+    m_Current->submitted = true;
+    m_Current            = nullptr;
+}
+
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char* name)
+{
+    if (m_Current == nullptr || m_Current->scopes.size() == m_MaxScopes)
+        return UINT32_MAX;
+
+    ScopeRecord scope = {};
+    scope.name            = name;
+    scope.parent          = m_Stack.empty() ? UINT32_MAX : m_Stack.back();
+    scope.depth           = (uint32_t)m_Stack.size();
+    scope.statisticsQuery = UINT32_MAX;
+
+    uint32_t index = (uint32_t)m_Current->scopes.size();
+
+    Device::vkCmdWriteTimestamp2KHR(commandBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, m_Current->timestamps, index * 2);
+
+    if (m_PipelineStatistics && scope.depth == 1)
+    {
+        scope.statisticsQuery = m_Current->statisticsCount++;
+
+        vkCmdBeginQuery(commandBuffer, m_Current->statistics, scope.statisticsQuery, 0x0);
+    }
+
+    m_Current->scopes.push_back(scope);
+    m_Stack.push_back(index);
+
+    return index;
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t scope)
+{
+    if (scope == UINT32_MAX || m_Current == nullptr)
+        return;
+
+    if (m_Stack.empty() || m_Stack.back() != scope)
+        throw std::runtime_error("gpu profiler scopes must be closed in reverse order.");
+
+    m_Stack.pop_back();
+
+    auto& record = m_Current->scopes[scope];
+
+    if (record.statisticsQuery != UINT32_MAX)
+        vkCmdEndQuery(commandBuffer, m_Current->statistics, record.statisticsQuery);
+
+    Device::vkCmdWriteTimestamp2KHR(commandBuffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, m_Current->timestamps, scope * 2 + 1);
+}
+
+void GpuProfiler::ReadResults(FrameQueries& queries)
+{
+    uint32_t scopeCount = (uint32_t)queries.scopes.size();
+
+    if (scopeCount == 0)
+        return;
+
+    m_Timestamps.resize(scopeCount * 2);
+
+    // No wait flag: results that aren't there yet leave the previous ones in place.
+    if (vkGetQueryPoolResults(m_Device->GetLogical(), queries.timestamps, 0, scopeCount * 2, sizeof(uint64_t) * m_Timestamps.size(),
+                              m_Timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        return;
+
+    if (queries.statisticsCount > 0)
+    {
+        m_Statistics.resize(queries.statisticsCount * s_StatisticCount);
+
+        if (vkGetQueryPoolResults(m_Device->GetLogical(), queries.statistics, 0, queries.statisticsCount, sizeof(uint64_t) * m_Statistics.size(),
+                                  m_Statistics.data(), sizeof(PipelineStatistics), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+            return;
+    }
+
+    m_Results.clear();
+
+    for (uint32_t i = 0; i < scopeCount; ++i)
+    {
+        auto& scope = queries.scopes[i];
+
+        Result result = {};
+        result.name         = scope.name;
+        result.parent       = scope.parent;
+        result.depth        = scope.depth;
+        result.milliseconds = (double)((m_Timestamps[i * 2 + 1] - m_Timestamps[i * 2]) & m_TimestampMask) * m_TimestampPeriod / 1e6;
+
+        if (scope.statisticsQuery != UINT32_MAX)
+        {
+            result.hasStatistics = true;
+            memcpy(&result.statistics, &m_Statistics[scope.statisticsQuery * s_StatisticCount], sizeof(PipelineStatistics));
+        }
+
+        m_Results.push_back(result);
+    }
+
+    m_ResultsFrame = queries.frameNumber;
+}
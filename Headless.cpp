@@ -0,0 +1,211 @@
+#include <VulkanWrappers/Headless.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/GpuProfiler.h>
+#include <VulkanWrappers/CpuTrace.h>
+#include <VulkanWrappers/FrameCommandPools.h>
+
+using namespace VulkanWrappers;
+
+static uint32_t GetTexelSize(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+        case VK_FORMAT_R32_SFLOAT:
+            return 4u;
+
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return 8u;
+
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return 16u;
+
+        default:
+            throw std::runtime_error("unsupported headless target format.");
+    }
+}
+
+Headless::Headless(Device* device, uint32_t width, uint32_t height, VkFormat format)
+    : m_Device(device), m_Format(format), m_FrameIndex(0)
+{
+    m_Viewport = { 0, 0, (float)width, (float)height, 0.0, 1.0 };
+    m_Scissor  = { 0, 0, width, height };
+
+    VkDeviceSize readbackSize = (VkDeviceSize)width * height * GetTexelSize(format);
+
+    std::vector<Image*>  images;
+    std::vector<Buffer*> buffers;
+
+    for (auto& target : m_Targets)
+    {
+        target.image        = Image(width, height, format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+        target.readback     = Buffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+        target.readbackData = nullptr;
+        target.frameNumber  = 0;
+
+        images.push_back(&target.image);
+        buffers.push_back(&target.readback);
+    }
+
+    device->CreateImages(images);
+    device->CreateBuffers(buffers);
+
+    for (auto& target : m_Targets)
+    {
+        VmaAllocationInfo allocationInfo = {};
+        vmaGetAllocationInfo(device->GetAllocator(), target.readback.GetData()->allocation, &allocationInfo);
+
+        target.readbackData = allocationInfo.pMappedData;
+    }
+}
+
+Headless::~Headless()
+{
+    std::vector<Image*>  images;
+    std::vector<Buffer*> buffers;
+
+    for (auto& target : m_Targets)
+    {
+        images.push_back(&target.image);
+        buffers.push_back(&target.readback);
+    }
+
+    m_Device->ReleaseImages(images);
+    m_Device->ReleaseBuffers(buffers);
+}
+
+bool Headless::NextFrame(Device* device, Frame* frame)
+{
+    CPU_TRACE_SCOPE("Headless::NextFrame");
+
+    // The number is fixed here, so the profiler and callers waiting on frame.number see the value SubmitFrame signals.
+    uint64_t frameNumber = device->AcquireFrameNumber();
+
+    // Pause thread until the graphics queue retired the last frame that used this slot.
+    if (frameNumber > NUM_FRAMES_IN_FLIGHT)
+        device->WaitForFrame(frameNumber - NUM_FRAMES_IN_FLIGHT);
+
+    device->BeginFrame(m_FrameIndex);
+
+    auto& target = m_Targets[m_FrameIndex];
+
+    frame->backBuffer     = target.image.GetData()->image;
+    frame->backBufferView = target.image.GetData()->view;
+    frame->index          = m_FrameIndex;
+    frame->number         = frameNumber;
+    frame->commandBuffer  = device->GetFrameCommandPools()->Allocate(m_FrameIndex);
+    frame->stateCache.Begin(frame->commandBuffer);
+
+    // Enable the command buffer into a recording state.
+    VkCommandBufferBeginInfo commandBegin = {};
+    commandBegin.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBegin.flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    commandBegin.pInheritanceInfo = nullptr;
+
+    vkBeginCommandBuffer(frame->commandBuffer, &commandBegin);
+
+    if (device->GetGpuProfiler() != nullptr)
+        device->GetGpuProfiler()->BeginFrame(frame);
+
+    return true;
+}
+
+void Headless::SubmitFrame(Device* device, const Frame* frame)
+{
+    CPU_TRACE_SCOPE("Headless::SubmitFrame");
+
+    auto& target = m_Targets[m_FrameIndex];
+
+    // Readback
+    // ---------------------
+
+    Image::TransferWriteToSource(frame->commandBuffer, target.image.GetData()->image);
+    Buffer::CopyImage(frame->commandBuffer, &target.image, &target.readback);
+
+    // Make the copy visible to the host once the frame retires.
+    VkMemoryBarrier2KHR hostBarrier = {};
+    hostBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+    hostBarrier.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    hostBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    hostBarrier.dstStageMask  = VK_PIPELINE_STAGE_2_HOST_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+
+    VkDependencyInfo dependencyInfo = {};
+    dependencyInfo.sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount = 1u;
+    dependencyInfo.pMemoryBarriers    = &hostBarrier;
+
+    Device::vkCmdPipelineBarrier2KHR(frame->commandBuffer, &dependencyInfo);
+
+    if (device->GetGpuProfiler() != nullptr)
+        device->GetGpuProfiler()->EndFrame(frame);
+
+    // Conclude command buffer recording.
+    vkEndCommandBuffer(frame->commandBuffer);
+
+    // Any uploads made during the frame land on the queue ahead of it.
+    device->FlushUploads();
+
+    // Primaries recorded by other threads run ahead of the frame's own command buffer.
+    m_SubmitCommandBuffers.clear();
+    device->GetFrameCommandPools()->TakeQueued(m_FrameIndex, &m_SubmitCommandBuffers);
+    m_SubmitCommandBuffers.push_back(frame->commandBuffer);
+
+    VkSemaphore timeline    = device->GetFrameTimeline();
+    uint64_t    frameNumber = frame->number;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1u;
+    timelineInfo.pSignalSemaphoreValues    = &frameNumber;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.commandBufferCount   = (uint32_t)m_SubmitCommandBuffers.size();
+    submitInfo.pCommandBuffers      = m_SubmitCommandBuffers.data();
+    submitInfo.signalSemaphoreCount = 1u;
+    submitInfo.pSignalSemaphores    = &timeline;
+
+    {
+        CPU_TRACE_SCOPE("vkQueueSubmit");
+        std::lock_guard<std::mutex> lock(device->GetQueueMutex());
+        vkQueueSubmit(device->GetGraphicsQueue(), 1u, &submitInfo, VK_NULL_HANDLE);
+    }
+
+    target.frameNumber = frameNumber;
+
+    // Compute next frame Index.
+    m_FrameIndex = (m_FrameIndex + 1) % NUM_FRAMES_IN_FLIGHT;
+}
+
+const void* Headless::GetReadback(uint64_t* frameNumber)
+{
+    uint64_t completedFrame = m_Device->GetCompletedFrame();
+
+    Target* latest = nullptr;
+
+    for (auto& target : m_Targets)
+    {
+        if (target.frameNumber == 0 || target.frameNumber > completedFrame)
+            continue;
+
+        if (latest == nullptr || target.frameNumber > latest->frameNumber)
+            latest = &target;
+    }
+
+    if (latest == nullptr)
+        return nullptr;
+
+    // No-op for coherent memory.
+    vmaInvalidateAllocation(m_Device->GetAllocator(), latest->readback.GetData()->allocation, 0, VK_WHOLE_SIZE);
+
+    if (frameNumber != nullptr)
+        *frameNumber = latest->frameNumber;
+
+    return latest->readbackData;
+}
@@ -1,19 +1,26 @@
 #include <VulkanWrappers/Image.h>
 #include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/BarrierBatch.h>
+
+#include <algorithm>
 
 using namespace VulkanWrappers;
 
-Image::Image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect):
+Image::Image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+             uint32_t mipLevels, uint32_t arrayLayers):
     m_Data()
 {
+    if (mipLevels > 1)
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
     m_Info = {};
     m_Info.image.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     m_Info.image.imageType = VK_IMAGE_TYPE_2D;
     m_Info.image.extent.width = width;
     m_Info.image.extent.height = height;
     m_Info.image.extent.depth = 1;
-    m_Info.image.mipLevels = 1;
-    m_Info.image.arrayLayers = 1;
+    m_Info.image.mipLevels = mipLevels;
+    m_Info.image.arrayLayers = arrayLayers;
     m_Info.image.format = format;
     m_Info.image.tiling = VK_IMAGE_TILING_OPTIMAL;
     m_Info.image.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -21,7 +28,7 @@ Image::Image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags
     m_Info.image.samples = VK_SAMPLE_COUNT_1_BIT;
     m_Info.view.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     m_Info.view.image = nullptr;
-    m_Info.view.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    m_Info.view.viewType = arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
     m_Info.view.format = format;
 
     m_Info.view.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -31,13 +38,103 @@ Image::Image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags
 
     m_Info.view.subresourceRange.aspectMask = aspect;
     m_Info.view.subresourceRange.baseMipLevel = 0;
-    m_Info.view.subresourceRange.levelCount = 1;
+    m_Info.view.subresourceRange.levelCount = mipLevels;
     m_Info.view.subresourceRange.baseArrayLayer = 0;
-    m_Info.view.subresourceRange.layerCount = 1;
+    m_Info.view.subresourceRange.layerCount = arrayLayers;
 
     m_Info.allocation.usage = VMA_MEMORY_USAGE_AUTO;
     m_Info.allocation.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
     m_Info.allocation.priority = 1.0;
+
+    m_Info.levelViews = false;
+
+    // Tracked from the start, so images bound by hand (without CreateImages) can go through a BarrierBatch too.
+    ResetState();
+}
+
+uint32_t Image::GetMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t mipCount = 1;
+
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+        mipCount++;
+
+    return mipCount;
+}
+
+void Image::ResetState()
+{
+    State initialState = {};
+    initialState.layout = m_Info.image.initialLayout;
+
+    m_State.assign(m_Info.image.mipLevels * m_Info.image.arrayLayers, initialState);
+}
+
+void Image::Transition(VkCommandBuffer commandBuffer, Image* image, VkImageLayout layout, VkPipelineStageFlags2 stage, VkAccessFlags2 access)
+{
+    BarrierBatch barriers(commandBuffer);
+    barriers.Transition(image, layout, stage, access);
+}
+
+void Image::GenerateMips(VkCommandBuffer commandBuffer, const Device* device, Image* image,
+                         VkImageLayout layout, VkPipelineStageFlags2 stage, VkAccessFlags2 access)
+{
+    auto& imageInfo = image->GetInfo()->image;
+
+    VkFormatProperties formatProperties = {};
+    vkGetPhysicalDeviceFormatProperties(device->GetPhysical(), imageInfo.format, &formatProperties);
+
+    auto features = formatProperties.optimalTilingFeatures;
+
+    if (!(features & VK_FORMAT_FEATURE_BLIT_SRC_BIT) || !(features & VK_FORMAT_FEATURE_BLIT_DST_BIT))
+        throw std::runtime_error("image format does not support mip generation by blits.");
+
+    // Box filter when the format can be filtered, otherwise every level is point sampled from the previous one.
+    VkFilter filter = (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+    auto aspect = image->GetInfo()->view.subresourceRange.aspectMask;
+
+    int32_t width  = (int32_t)imageInfo.extent.width;
+    int32_t height = (int32_t)imageInfo.extent.height;
+
+    for (uint32_t level = 1; level < imageInfo.mipLevels; ++level)
+    {
+        VkImageSubresourceRange srcRange = { aspect, level - 1, 1, 0, imageInfo.arrayLayers };
+        VkImageSubresourceRange dstRange = { aspect, level,     1, 0, imageInfo.arrayLayers };
+
+        {
+            BarrierBatch barriers(commandBuffer);
+            barriers.Transition(image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,  &srcRange);
+            barriers.Transition(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, &dstRange);
+        }
+
+        int32_t levelWidth  = std::max(width  >> 1, 1);
+        int32_t levelHeight = std::max(height >> 1, 1);
+
+        VkImageBlit2KHR blit = {};
+        blit.sType          = VK_STRUCTURE_TYPE_IMAGE_BLIT_2_KHR;
+        blit.srcSubresource = { aspect, level - 1, 0, imageInfo.arrayLayers };
+        blit.srcOffsets[1]  = { width, height, 1 };
+        blit.dstSubresource = { aspect, level, 0, imageInfo.arrayLayers };
+        blit.dstOffsets[1]  = { levelWidth, levelHeight, 1 };
+
+        VkBlitImageInfo2KHR blitInfo = {};
+        blitInfo.sType          = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2_KHR;
+        blitInfo.srcImage       = image->GetData()->image;
+        blitInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        blitInfo.dstImage       = image->GetData()->image;
+        blitInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        blitInfo.regionCount    = 1u;
+        blitInfo.pRegions       = &blit;
+        blitInfo.filter         = filter;
+
+        Device::vkCmdBlitImage2KHR(commandBuffer, &blitInfo);
+
+        width  = levelWidth;
+        height = levelHeight;
+    }
+
+    Transition(commandBuffer, image, layout, stage, access);
 }
 
 // Transition Utilities
@@ -72,9 +169,9 @@ static void Transition(TransitionArgs args)
     imageBarrier.subresourceRange = {};
     imageBarrier.subresourceRange.aspectMask     = args.aspect;
     imageBarrier.subresourceRange.baseMipLevel   = 0;
-    imageBarrier.subresourceRange.levelCount     = 1;
+    imageBarrier.subresourceRange.levelCount     = VK_REMAINING_MIP_LEVELS;
     imageBarrier.subresourceRange.baseArrayLayer = 0;
-    imageBarrier.subresourceRange.layerCount     = 1;
+    imageBarrier.subresourceRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
     VkDependencyInfo dependencyInfo ={};
 
     dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
@@ -161,4 +258,45 @@ void Image::TransferDestinationToPresent(VkCommandBuffer commandBuffer, VkImage
 
 
     Transition(args);
-}
\ No newline at end of file
+}
+
+static void OwnershipBarrier(VkCommandBuffer commandBuffer, Image* image, uint32_t srcFamily, uint32_t dstFamily, 
+                             VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, 
+                             VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess,
+                             VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    if (srcFamily == dstFamily)
+        return;
+
+    VkImageMemoryBarrier2KHR imageBarrier = {};
+    imageBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+    imageBarrier.srcStageMask        = srcStage;
+    imageBarrier.srcAccessMask       = srcAccess;
+    imageBarrier.dstStageMask        = dstStage;
+    imageBarrier.dstAccessMask       = dstAccess;
+    imageBarrier.oldLayout           = oldLayout;
+    imageBarrier.newLayout           = newLayout;
+    imageBarrier.srcQueueFamilyIndex = srcFamily;
+    imageBarrier.dstQueueFamilyIndex = dstFamily;
+    imageBarrier.image               = image->GetData()->image;
+    imageBarrier.subresourceRange    = image->GetInfo()->view.subresourceRange;
+
+    VkDependencyInfo dependencyInfo = {};
+    dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.imageMemoryBarrierCount = 1u;
+    dependencyInfo.pImageMemoryBarriers    = &imageBarrier;
+
+    Device::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+}
+
+void Image::ReleaseOwnership(VkCommandBuffer commandBuffer, Image* image, uint32_t srcFamily, uint32_t dstFamily, 
+                             VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    OwnershipBarrier(commandBuffer, image, srcFamily, dstFamily, srcStage, srcAccess, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, oldLayout, newLayout);
+}
+
+void Image::AcquireOwnership(VkCommandBuffer commandBuffer, Image* image, uint32_t srcFamily, uint32_t dstFamily, 
+                             VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    OwnershipBarrier(commandBuffer, image, srcFamily, dstFamily, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, dstStage, dstAccess, oldLayout, newLayout);
+}
@@ -0,0 +1,80 @@
+#ifndef ALIASING_POOL
+#define ALIASING_POOL
+
+#include <vulkan/vulkan.h>
+
+#include <VulkanWrappers/VmaUsage.h>
+
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+    class Image;
+
+    // Places images whose lifetimes don't overlap on shared memory instead of a dedicated allocation each.
+    //
+    // Lifetimes are [firstUse, lastUse] in any ordering the caller picks (e.g. pass indices in a frame).
+    // Build() groups the images into slots, allocates one block per slot sized for its largest image and creates
+    // every image into it with vmaCreateAliasingImage. Slots made only of transient attachments go to lazily
+    // allocated memory where the device has it, so tile-based GPUs may never back them with physical memory.
+    class AliasingPool
+    {
+    public:
+        AliasingPool(Device* device);
+        ~AliasingPool();
+
+        AliasingPool(const AliasingPool&) = delete;
+        AliasingPool& operator=(const AliasingPool&) = delete;
+
+        // Registers an image from its Info (not yet created), returns its entry for Claim().
+        uint32_t Add(Image* image, uint32_t firstUse, uint32_t lastUse);
+
+        // Creates all added images, their views and the shared memory.
+        void Build();
+
+        // Releases the images and the memory, the pool can be filled again afterwards.
+        void Release();
+
+        // Marks the entry's image as the current user of its memory and returns the image that used it before
+        // (possibly itself, nullptr if none), whose work has to complete before the memory is overwritten.
+        Image* Claim(uint32_t entry);
+
+        // Whether images with only attachment usages can be given VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT.
+        inline bool SupportsLazyAllocation() const { return m_SupportsLazyAllocation; }
+
+        // Device memory allocated by the pool, against the sum of what the images would take on their own.
+        inline VkDeviceSize GetAllocatedSize() const { return m_AllocatedSize; }
+        inline VkDeviceSize GetRequestedSize() const { return m_RequestedSize; }
+
+    private:
+        struct Entry
+        {
+            Image*               image;
+            uint32_t             firstUse;
+            uint32_t             lastUse;
+            uint32_t             slot;
+            VkMemoryRequirements requirements;
+        };
+
+        struct Slot
+        {
+            VmaAllocation         allocation;
+            VkMemoryRequirements  requirements;
+            bool                  lazy;
+            std::vector<uint32_t> entries;
+            Image*                lastOccupant;
+        };
+
+        Device* m_Device;
+
+        std::vector<Entry> m_Entries;
+        std::vector<Slot>  m_Slots;
+
+        bool         m_SupportsLazyAllocation;
+        VkDeviceSize m_AllocatedSize;
+        VkDeviceSize m_RequestedSize;
+    };
+}
+
+#endif//ALIASING_POOL
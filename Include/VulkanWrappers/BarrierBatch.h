@@ -0,0 +1,55 @@
+#ifndef BARRIER_BATCH
+#define BARRIER_BATCH
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Image;
+    class Buffer;
+
+    // Gathers the transitions needed by the next commands and records them as one vkCmdPipelineBarrier2KHR.
+    // The previous layout / stage / access comes from the state tracked on each Image subresource and Buffer,
+    // and transitions that change nothing (e.g. read after read in the same layout) are skipped.
+    // Pending barriers are flushed on destruction, or when a resource is transitioned twice in one batch (for images,
+    // only when the subresource ranges overlap, so e.g. two mip levels of one image share a barrier).
+    class BarrierBatch
+    {
+    public:
+        BarrierBatch(VkCommandBuffer commandBuffer) : m_CommandBuffer(commandBuffer) {}
+        ~BarrierBatch() { Flush(); }
+
+        // Transitions a subresource range (the whole image when null) for its next use.
+        void Transition(Image* image, VkImageLayout layout, VkPipelineStageFlags2 stage, VkAccessFlags2 access, const VkImageSubresourceRange* range = nullptr);
+
+        // Makes the buffer's previous use visible to its next one.
+        void Transition(Buffer* buffer, VkPipelineStageFlags2 stage, VkAccessFlags2 access);
+
+        // Orders all memory between two uses, independent of any resource (e.g. memory handed to an aliased image).
+        void GlobalBarrier(VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess);
+
+        void Flush();
+
+    private:
+        struct PendingResource
+        {
+            const void*             resource;
+
+            // Levels and layers of an image, buffers are always whole.
+            VkImageSubresourceRange range;
+        };
+
+        bool IsPending(const void* resource, const VkImageSubresourceRange* range = nullptr) const;
+
+        VkCommandBuffer m_CommandBuffer;
+
+        std::vector<VkMemoryBarrier2KHR>       m_MemoryBarriers;
+        std::vector<VkImageMemoryBarrier2KHR>  m_ImageBarriers;
+        std::vector<VkBufferMemoryBarrier2KHR> m_BufferBarriers;
+        std::vector<PendingResource>           m_PendingResources;
+    };
+}
+
+#endif//BARRIER_BATCH
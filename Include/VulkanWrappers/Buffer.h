@@ -19,29 +19,61 @@ namespace VulkanWrappers
 
         struct Data
         {
-            VkBuffer      buffer;
-            VkBufferView  view;
-            VmaAllocation allocation;
+            VkBuffer        buffer;
+            VkBufferView    view;
+            VmaAllocation   allocation;
+
+            // GPU pointer to the buffer for shaders (e.g. passed through push constants).
+            VkDeviceAddress address;
+
+            // Index in the device's DescriptorHeap, 0 without storage usage.
+            uint32_t        storageIndex;
         };
 
     public:
 
+        // Last known use of the buffer, tracked on the CPU in recording order (see BarrierBatch).
+        struct State
+        {
+            // Last write, and the stages / accesses a barrier made it visible to since.
+            VkPipelineStageFlags2 writeStage;
+            VkAccessFlags2        writeAccess;
+            VkPipelineStageFlags2 visibleStages;
+            VkAccessFlags2        visibleAccess;
+
+            // Stages that read since the last write, a later write waits on them.
+            VkPipelineStageFlags2 readStages;
+        };
+
         Buffer() {}
         Buffer(VkDeviceSize             size, 
                VkBufferUsageFlags       useFlags, 
                VmaAllocationCreateFlags memFlags);
 
-        static void SetData(Device* device, Buffer* buffer, void* srcPtr, uint32_t size);
+        // Writes host memory into the buffer. Host-visible allocations (VMA HOST_ACCESS_* flags) are written
+        // directly, everything else is staged through the device's staging ring and copied on the next flush.
+        // Direct writes happen immediately and are not ordered with frames in flight: the caller must make
+        // sure the GPU no longer reads the range (e.g. by writing a per-frame copy).
+        static void SetData(Device* device, Buffer* buffer, const void* srcPtr, uint32_t size, VkDeviceSize offset = 0);
 
         // Copies an image resource into a buffer resource. 
         static void CopyImage(VkCommandBuffer cmd, Image* image, Buffer* buffer);
 
+        // Queue family ownership transfer: the release is recorded on the source queue, the acquire on the
+        // destination queue after a semaphore wait. No barrier is needed when both families are the same.
+        static void ReleaseOwnership(VkCommandBuffer cmd, Buffer* buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess);
+        static void AcquireOwnership(VkCommandBuffer cmd, Buffer* buffer, uint32_t srcFamily, uint32_t dstFamily, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess);
+
         inline Info* GetInfo() { return &m_Info; }
         inline Data* GetData() { return &m_Data; }
 
+        inline State* GetState() { return &m_State; }
+
     private:
         Info m_Info;
         Data m_Data;
+
+        State m_State = {};
     };
 }
 
@@ -0,0 +1,85 @@
+#ifndef BUFFER_ARENA
+#define BUFFER_ARENA
+
+#include <vulkan/vulkan.h>
+
+#include <VulkanWrappers/VmaUsage.h>
+#include <VulkanWrappers/Buffer.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+
+    // Range of one of the arena's buffers, bind it as (buffer, offset, size).
+    struct BufferSlice
+    {
+        Buffer*      buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+
+        // Host pointer to the slice when the arena's memory is mapped, nullptr otherwise.
+        void*        mapped;
+
+        // GPU pointer to the slice.
+        VkDeviceAddress address;
+
+        VmaVirtualAllocation allocation;
+        uint32_t             block;
+    };
+
+    // Hands out slices of a few large buffers instead of one VkBuffer (and allocation) per small buffer.
+    // Slices are tracked with VMA virtual blocks, a new block of blockSize is added whenever the existing ones are full.
+    //
+    // With linear, the blocks use VMA's linear algorithm: allocation is a pointer bump and the arena is meant to be
+    // Reset() in bulk, e.g. one arena per frame in flight reset once that frame retired.
+    // Free() and Reset() are immediate, the caller makes sure the GPU is done with the slices.
+    class BufferArena
+    {
+    public:
+        BufferArena(Device* device, VkDeviceSize blockSize, VkBufferUsageFlags usage, VmaAllocationCreateFlags memFlags, bool linear = false);
+        ~BufferArena();
+
+        BufferArena(const BufferArena&) = delete;
+        BufferArena& operator=(const BufferArena&) = delete;
+
+        // Alignment of 0 uses the device's minimum offset alignment for the arena's usage.
+        BufferSlice Allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+        void        Free(const BufferSlice& slice);
+
+        // Frees every slice at once, the buffers are kept.
+        void Reset();
+
+        // Buffer::SetData on the slice's range.
+        void SetData(const BufferSlice& slice, const void* srcPtr, uint32_t size, VkDeviceSize offset = 0);
+
+        inline VkDeviceSize GetBlockSize()  const { return m_BlockSize; }
+        inline uint32_t     GetBlockCount() const { return (uint32_t)m_Blocks.size(); }
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<Buffer> buffer;
+            VmaVirtualBlock         virtualBlock;
+            void*                   mapped;
+        };
+
+        void AddBlock();
+
+        Device* m_Device;
+
+        VkDeviceSize             m_BlockSize;
+        VkBufferUsageFlags       m_Usage;
+        VmaAllocationCreateFlags m_MemFlags;
+        VkDeviceSize             m_MinAlignment;
+        bool                     m_Linear;
+
+        std::mutex         m_Mutex;
+        std::vector<Block> m_Blocks;
+    };
+}
+
+#endif//BUFFER_ARENA
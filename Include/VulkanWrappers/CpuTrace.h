@@ -0,0 +1,62 @@
+#ifndef CPU_TRACE
+#define CPU_TRACE
+
+// CPU timeline of the frame loop (waits, acquire, submit, present), the Device::Create* calls and user scopes,
+// exported as Chrome trace-event JSON (chrome://tracing, Perfetto). Only compiled with VULKAN_WRAPPERS_TRACE
+// defined (the CMake option of the same name), otherwise the macros expand to nothing.
+//
+//   CPU_TRACE_SCOPE("Culling");
+//   CPU_TRACE_EXPORT("frame.json");
+
+#ifdef VULKAN_WRAPPERS_TRACE
+
+#include <stdint.h>
+
+namespace VulkanWrappers
+{
+    // Events kept per thread, the oldest are overwritten.
+    #define CPU_TRACE_RING_SIZE 65536u
+
+    class CpuTrace
+    {
+    public:
+        class Scope
+        {
+        public:
+            Scope(const char* name) : m_Name(name), m_Begin(CpuTrace::Now()) {}
+            ~Scope() { CpuTrace::Record(m_Name, m_Begin, CpuTrace::Now()); }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            const char* m_Name;
+            uint64_t    m_Begin;
+        };
+
+        // Nanoseconds on a steady clock.
+        static uint64_t Now();
+
+        // Appends a completed event to the calling thread's ring, names must stay valid (e.g. string literals).
+        static void Record(const char* name, uint64_t begin, uint64_t end);
+
+        // Writes every thread's events, meant for when the recording threads are idle (a ring that wraps while it
+        // is read can hand out overwritten events). Returns false when the file can't be written.
+        static bool WriteChromeTrace(const char* filePath);
+    };
+}
+
+#define CPU_TRACE_CONCAT_IMPL(a, b) a##b
+#define CPU_TRACE_CONCAT(a, b)      CPU_TRACE_CONCAT_IMPL(a, b)
+
+#define CPU_TRACE_SCOPE(name)      VulkanWrappers::CpuTrace::Scope CPU_TRACE_CONCAT(cpuTraceScope, __LINE__)(name)
+#define CPU_TRACE_EXPORT(filePath) VulkanWrappers::CpuTrace::WriteChromeTrace(filePath)
+
+#else
+
+#define CPU_TRACE_SCOPE(name)
+#define CPU_TRACE_EXPORT(filePath)
+
+#endif//VULKAN_WRAPPERS_TRACE
+
+#endif//CPU_TRACE
@@ -0,0 +1,88 @@
+#ifndef DESCRIPTOR_HEAP
+#define DESCRIPTOR_HEAP
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+    class Image;
+    class Buffer;
+
+    // Global bindless table, one update-after-bind descriptor set (set 0 of the device's pipeline layout) with a
+    // partially bound array per descriptor type. Images and buffers are registered by Device::Create* according to
+    // their usage and shaders index the arrays with the integer handles stored in their Data. Index 0 is never
+    // handed out, so a zeroed handle always means "not registered". Freed indices are only reused once the frame
+    // that released the resource retired (through the device's deferred releases).
+    //
+    // GLSL:
+    //   layout(set = 0, binding = 0) uniform texture2D      g_Textures[];
+    //   layout(set = 0, binding = 1) uniform image2D        g_StorageImages[];
+    //   layout(set = 0, binding = 2) buffer  StorageBuffer  { uint data[]; } g_Buffers[];
+    //   layout(set = 0, binding = 3) uniform sampler        g_Samplers[];
+    class DescriptorHeap
+    {
+    public:
+        enum Binding
+        {
+            SampledImages  = 0,
+            StorageImages  = 1,
+            StorageBuffers = 2,
+            Samplers       = 3,
+            BindingCount
+        };
+
+        DescriptorHeap(Device* device);
+        ~DescriptorHeap();
+
+        DescriptorHeap(const DescriptorHeap&) = delete;
+        DescriptorHeap& operator=(const DescriptorHeap&) = delete;
+
+        // Gives the resource an index for each of its shader usages (sampled / storage).
+        void Register(Image* image);
+        void Register(Buffer* buffer);
+
+        // Rewrites the image's descriptors, e.g. after its view was recreated.
+        void Update(Image* image);
+
+        // Returns an index to the table, the GPU must be done with it.
+        void Free(Binding binding, uint32_t index);
+
+        // Heap-owned sampler, returns its index in the sampler array.
+        uint32_t CreateSampler(const VkSamplerCreateInfo& samplerInfo);
+
+        // Binds the table for every shader recorded after it, once per command buffer and bind point.
+        void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+        inline const VkDescriptorSetLayout* GetSetLayout() const { return &m_VKSetLayout; }
+
+        inline uint32_t GetCapacity(Binding binding) const { return m_Tables[binding].capacity; }
+
+    private:
+        struct Table
+        {
+            uint32_t              capacity;
+            uint32_t              next;
+            std::vector<uint32_t> freeIndices;
+        };
+
+        uint32_t Allocate(Binding binding);
+        void     WriteImage(Image* image);
+
+        Device* m_Device;
+
+        VkDescriptorSetLayout m_VKSetLayout;
+        VkDescriptorPool      m_VKPool;
+        VkDescriptorSet       m_VKSet;
+
+        std::mutex                      m_Mutex;
+        std::array<Table, BindingCount> m_Tables;
+        std::vector<VkSampler>          m_Samplers;
+    };
+}
+
+#endif//DESCRIPTOR_HEAP
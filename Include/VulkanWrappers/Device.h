@@ -9,6 +9,10 @@
 #include <vulkan/vulkan.h>
 #include <VulkanWrappers/VmaUsage.h>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include "stdexcept"
 // Extension Functions
 // -----------------------
@@ -19,6 +23,17 @@ namespace VulkanWrappers
     class Shader;
     class Buffer;
     class Image;
+    class StagingRing;
+    class ShaderCache;
+    class TaskPool;
+    class FrameCommandPools;
+    class FrameAllocator;
+    class DescriptorHeap;
+    class GpuProfiler;
+
+    // Push-constant block shared by every shader (the minimum maxPushConstantsSize), visible to all stages.
+    // Large per-draw data goes through buffer device addresses placed in it.
+    #define PUSH_CONSTANT_SIZE 128u
 
     class Device
     {
@@ -31,12 +46,48 @@ namespace VulkanWrappers
         inline VkPhysicalDevice GetPhysical() const { return m_VKDevicePhysical; }
         inline VkDevice GetLogical()          const { return m_VKDeviceLogical;  }
         inline VkCommandPool GetCommandPool() const { return m_VKCommandPool;    }
+        inline VkPipelineLayout GetPipelineLayout() const { return m_VKPipelineLayout; }
         inline VkQueue GetGraphicsQueue()     const { return m_VKQueueGraphics;  }
         inline VkQueue GetPresentQueue()      const { return m_VKQueuePresent;   }
+        inline VkQueue GetTransferQueue()     const { return m_VKQueueTransfer;  }
+        inline VkQueue GetComputeQueue()      const { return m_VKQueueCompute;   }
+
+        inline uint32_t GetGraphicsQueueFamily() const { return m_VKQueueGraphicsIndex; }
+        inline uint32_t GetPresentQueueFamily()  const { return m_VKQueuePresentIndex;  }
+        inline uint32_t GetTransferQueueFamily() const { return m_VKQueueTransferIndex; }
+        inline uint32_t GetComputeQueueFamily()  const { return m_VKQueueComputeIndex;  }
+
+        // Graphics stages enabled on the device (vertex and fragment, tessellation / geometry when supported).
+        inline VkShaderStageFlags GetGraphicsShaderStages() const { return m_GraphicsShaderStages; }
+
+        inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return m_EnabledFeatures; }
+
+        // When false, the transfer / compute queue is the graphics queue.
+        inline bool HasDedicatedTransferQueue() const { return m_HasDedicatedTransferQueue; }
+        inline bool HasDedicatedComputeQueue()  const { return m_HasDedicatedComputeQueue;  }
         inline VmaAllocator GetAllocator()    const { return m_VMAAllocator;     }
+        inline StagingRing* GetStagingRing()  const { return m_StagingRing.get(); }
 
+        inline FrameCommandPools* GetFrameCommandPools() const { return m_FrameCommandPools.get(); }
+        inline FrameAllocator*    GetFrameAllocator()    const { return m_FrameAllocator.get();    }
+        inline DescriptorHeap*    GetDescriptorHeap()    const { return m_DescriptorHeap.get();    }
+
+        // Sets every dynamic state unconditionally, recording many draws should go through a StateCache instead.
         static void SetDefaultRenderState(VkCommandBuffer VkCommandBuffer);
 
+        // Writes into the shared push-constant block for the shaders bound after it.
+        void PushConstants(VkCommandBuffer commandBuffer, const void* data, uint32_t size, uint32_t offset = 0) const;
+
+        // Optional cache consulted by CreateShaders (owned by the caller).
+        inline void SetShaderCache(ShaderCache* shaderCache) { m_ShaderCache = shaderCache; }
+
+        // Optional profiler driven by the frame loop (owned by the caller).
+        inline void         SetGpuProfiler(GpuProfiler* gpuProfiler) { m_GpuProfiler = gpuProfiler; }
+        inline GpuProfiler* GetGpuProfiler() const                   { return m_GpuProfiler;        }
+
+        // Queues need external synchronization, every vkQueueSubmit / vkQueuePresentKHR / vkDeviceWaitIdle holds this.
+        inline std::mutex& GetQueueMutex() { return m_QueueMutex; }
+
         inline void CreateCommandBuffer(VkCommandBuffer* commandBuffer, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) const
         { 
             VkCommandBufferAllocateInfo commandAllocateInfo = {};
@@ -50,7 +101,14 @@ namespace VulkanWrappers
         }
 
         // Utility
-        void CreateShaders  (const std::vector<Shader*>& shaders);
+        // Release* calls are deferred: the objects are destroyed in bulk once the frame after the latest one
+        // (GetAcquiredFrame() + 1) has retired, which covers the frame being recorded, so callers never have to
+        // wait for the GPU. Objects released outside a frame loop wait for the next frame submission too, or for
+        // the Device's destruction.
+        //
+        // Shaders are created in one native call. With linkStages, consecutive shaders that chain through
+        // nextStage (e.g. vertex -> fragment) are created as a linked set so the driver can optimize across stages.
+        void CreateShaders  (const std::vector<Shader*>& shaders, bool linkStages = false);
         void ReleaseShaders (const std::vector<Shader*>& shaders);
 
         void CreateBuffers  (const std::vector<Buffer*>& buffers);
@@ -59,6 +117,41 @@ namespace VulkanWrappers
         void CreateImages  (const std::vector<Image*>& images);
         void ReleaseImages (const std::vector<Image*>& images);
 
+        // Rebuilds the views from GetInfo()->view (e.g. to another level range). The old views and descriptor indices
+        // are released like the images would be, so the images get new indices in the descriptor heap.
+        void UpdateImageViews (const std::vector<Image*>& images);
+
+        // Raw VMA memory that images or buffers were bound to by hand.
+        void ReleaseAllocations (const std::vector<VmaAllocation>& allocations);
+
+        // Spreads the Create* calls over a worker pool (0 picks the core count, 1 goes back to serial).
+        // Failures for a whole batch are reported together in one exception once the batch finished,
+        // the resources that did get created are left for the caller to release as usual.
+        void SetCreationThreadCount(uint32_t threadCount);
+
+        // Submits all pending Buffer::SetData copies in one batch.
+        void FlushUploads();
+
+        // Recycles the per-frame state of a frame-in-flight slot once the GPU retired it (called by the frame loop).
+        void BeginFrame(uint32_t frameIndex);
+
+        // Frame Timeline
+        // Every frame submission signals its frame number (starting at 1) on one timeline semaphore, so
+        // "has frame N retired" is an integer comparison against GetCompletedFrame().
+        inline VkSemaphore GetFrameTimeline()  const { return m_VKFrameTimeline; }
+        inline uint64_t    GetAcquiredFrame()  const { return m_AcquiredFrame.load(std::memory_order_acquire); }
+
+        uint64_t GetCompletedFrame() const;
+        void     WaitForFrame(uint64_t frameNumber) const;
+
+        // Reserves the number a frame signals when it is submitted (called by the frame loop's NextFrame). Frames
+        // must be submitted in the order their numbers were acquired, timeline values only go up.
+        uint64_t AcquireFrameNumber();
+
+        // Destroys released objects whose frame retired (BeginFrame does this every frame). Frees nothing until
+        // a frame is submitted after the Release* call, so it is a no-op without a frame loop.
+        void CollectReleases();
+
         inline Window* GetWindow() { return m_Window; }
         
         ~Device();
@@ -71,6 +164,7 @@ namespace VulkanWrappers
         VK_FUNC_MEMBER(vkCmdPipelineBarrier2KHR);
         VK_FUNC_MEMBER(vkCreateShadersEXT);
         VK_FUNC_MEMBER(vkDestroyShaderEXT);
+        VK_FUNC_MEMBER(vkGetShaderBinaryDataEXT);
         VK_FUNC_MEMBER(vkCmdBindShadersEXT);
         VK_FUNC_MEMBER(vkCmdSetPrimitiveTopologyEXT);
         VK_FUNC_MEMBER(vkCmdSetColorWriteMaskEXT);
@@ -90,16 +184,76 @@ namespace VulkanWrappers
         VK_FUNC_MEMBER(vkCmdSetScissorWithCountEXT);
         VK_FUNC_MEMBER(vkCmdSetRasterizationSamplesEXT);
         VK_FUNC_MEMBER(vkCmdSetSampleMaskEXT);
+        VK_FUNC_MEMBER(vkCmdBlitImage2KHR);
+        VK_FUNC_MEMBER(vkCmdWriteTimestamp2KHR);
+        VK_FUNC_MEMBER(vkGetDeviceImageMemoryRequirementsKHR);
 
     private:
+        struct DeferredRelease
+        {
+            uint64_t      frameNumber;
+            VkBuffer      buffer;
+            VkBufferView  bufferView;
+            VkImage       image;
+            VkImageView   imageView;
+            VkShaderEXT   shader;
+            VmaAllocation allocation;
+
+            // Descriptor heap indices to recycle.
+            uint32_t      sampledIndex;
+            uint32_t      storageImageIndex;
+            uint32_t      storageBufferIndex;
+        };
+
+        void DeferRelease(DeferredRelease release);
+        void DestroyRelease(const DeferredRelease& release);
+
         VkInstance       m_VKInstance;
         VkPhysicalDevice m_VKDevicePhysical;
         VkDevice         m_VKDeviceLogical;
         VkCommandPool    m_VKCommandPool;
 
+        VkShaderStageFlags       m_GraphicsShaderStages;
+        VkPhysicalDeviceFeatures m_EnabledFeatures;
+
+        // Binding model shared by all shaders
+        VkPipelineLayout    m_VKPipelineLayout;
+        VkPushConstantRange m_PushConstantRange;
+
+        std::unique_ptr<DescriptorHeap> m_DescriptorHeap;
+
         // Memory Allocation (VMA)
         VmaAllocator m_VMAAllocator;
 
+        // Uploads
+        std::unique_ptr<StagingRing> m_StagingRing;
+
+        // Per-thread, per-frame command recording
+        std::unique_ptr<FrameCommandPools> m_FrameCommandPools;
+
+        // Per-frame dynamic data
+        std::unique_ptr<FrameAllocator> m_FrameAllocator;
+
+        // Frame pacing
+        VkSemaphore           m_VKFrameTimeline;
+        std::atomic<uint64_t> m_AcquiredFrame;
+
+        // Queue submission
+        std::mutex m_QueueMutex;
+
+        // Deferred destruction
+        std::mutex                  m_ReleaseMutex;
+        std::deque<DeferredRelease> m_DeferredReleases;
+
+        // Shader Binaries
+        ShaderCache* m_ShaderCache;
+
+        // Frame timings
+        GpuProfiler* m_GpuProfiler;
+
+        // Parallel resource creation
+        std::unique_ptr<TaskPool> m_TaskPool;
+
         // Window Handle
         Window* m_Window;
 
@@ -110,6 +264,16 @@ namespace VulkanWrappers
         // Present Queue
         VkQueue  m_VKQueuePresent;
         uint32_t m_VKQueuePresentIndex;
+
+        // Transfer Queue (copy engine)
+        VkQueue  m_VKQueueTransfer;
+        uint32_t m_VKQueueTransferIndex;
+        bool     m_HasDedicatedTransferQueue;
+
+        // Async Compute Queue
+        VkQueue  m_VKQueueCompute;
+        uint32_t m_VKQueueComputeIndex;
+        bool     m_HasDedicatedComputeQueue;
     };
 }
 
@@ -0,0 +1,123 @@
+#ifndef DRAW_BATCHER
+#define DRAW_BATCHER
+
+#include <vulkan/vulkan.h>
+#include <VulkanWrappers/Buffer.h>
+#include <VulkanWrappers/BufferArena.h>
+
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+    class ShaderProgram;
+    class StateCache;
+    struct RenderState;
+
+    // Gathers indexed draws for one frame, sorts them by program and render state, and records one
+    // vkCmdDrawIndexedIndirectCount per (program, state) batch. Every draw reads the same index buffer, which
+    // the caller binds before Draw. States are grouped by address, so reuse the same RenderState objects.
+    //
+    // The sorted records and per-batch counts live in the device's frame memory. Without culling they are
+    // drawn as they are. With culling, a compute pass recorded between PrepareCull and FinishCull reads the
+    // records and appends the visible ones to the batcher's device-local output. Both calls record barriers,
+    // so they go outside of the rendering that Draw is recorded in:
+    //
+    //   layout(push_constant) uniform Cull { DrawRecords records; DrawRecords culledRecords; Counts culledCounts; uint drawCount; };
+    //
+    //   DrawRecord draw = records.data[gl_GlobalInvocationID.x];
+    //   if (IsVisible(draw.bounds))
+    //       culledRecords.data[draw.batchOffset + atomicAdd(culledCounts.data[draw.batch], 1)] = draw;
+    class DrawBatcher
+    {
+    public:
+        // std430 compatible, the indirect stride is sizeof(DrawRecord).
+        struct DrawRecord
+        {
+            // firstInstance is free to index per-draw data (gl_InstanceIndex).
+            VkDrawIndexedIndirectCommand command;
+
+            // Filled by Build: the batch, and where its records start.
+            uint32_t                     batch;
+            uint32_t                     batchOffset;
+            uint32_t                     padding;
+
+            // Bounding sphere for culling (center xyz, radius w).
+            float                        bounds[4];
+        };
+
+        // Push-constant layout for the culling shader.
+        struct CullParameters
+        {
+            VkDeviceAddress records;
+            VkDeviceAddress culledRecords;
+            VkDeviceAddress culledCounts;
+            uint32_t        drawCount;
+        };
+
+        DrawBatcher(Device* device, uint32_t maxDraws);
+        ~DrawBatcher();
+
+        DrawBatcher(const DrawBatcher&) = delete;
+        DrawBatcher& operator=(const DrawBatcher&) = delete;
+
+        void Add(const ShaderProgram* program, const RenderState* state, const VkDrawIndexedIndirectCommand& command, const float* bounds = nullptr);
+
+        // Sorts the draws into batches and writes the records and counts for the current frame.
+        void Build();
+
+        // Clears the culled counts and makes the output writable by the culling dispatch that follows.
+        void PrepareCull(VkCommandBuffer commandBuffer);
+
+        // Makes the culling dispatch's output readable as indirect draws, before the rendering begins.
+        void FinishCull(VkCommandBuffer commandBuffer);
+
+        inline CullParameters GetCullParameters() const { return m_CullParameters; }
+
+        // Binds each batch's program / state through the cache and draws it, from the culled output after FinishCull.
+        // Records no barriers, call it inside vkCmdBeginRendering.
+        void Draw(StateCache* stateCache);
+
+        // Drops the draws, for the next frame.
+        void Reset();
+
+        inline uint32_t GetDrawCount()  const { return (uint32_t)m_Draws.size();   }
+        inline uint32_t GetBatchCount() const { return (uint32_t)m_Batches.size(); }
+
+    private:
+        struct PendingDraw
+        {
+            const ShaderProgram* program;
+            const RenderState*   state;
+            DrawRecord           record;
+        };
+
+        struct Batch
+        {
+            const ShaderProgram* program;
+            const RenderState*   state;
+            uint32_t             first;
+            uint32_t             count;
+        };
+
+        Device*  m_Device;
+        uint32_t m_MaxDraws;
+
+        std::vector<PendingDraw> m_Draws;
+        std::vector<uint32_t>    m_Order;
+        std::vector<Batch>       m_Batches;
+
+        // Current frame's sorted records and counts.
+        BufferSlice m_Records;
+        BufferSlice m_Counts;
+
+        // Culling output, written on the GPU.
+        Buffer m_CulledRecords;
+        Buffer m_CulledCounts;
+        bool   m_Culled;
+
+        CullParameters m_CullParameters;
+    };
+}
+
+#endif//DRAW_BATCHER
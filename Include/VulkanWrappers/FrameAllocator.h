@@ -0,0 +1,57 @@
+#ifndef FRAME_ALLOCATOR
+#define FRAME_ALLOCATOR
+
+#include <VulkanWrappers/VmaUsage.h>
+#include <VulkanWrappers/Window.h>
+#include <VulkanWrappers/Buffer.h>
+#include <VulkanWrappers/BufferArena.h>
+
+#include <array>
+#include <atomic>
+
+namespace VulkanWrappers
+{
+    class Device;
+
+    // Size of the per-frame memory owned by each device, for each frame in flight.
+    #define FRAME_ALLOCATOR_SIZE (16ull * 1024ull * 1024ull)
+
+    // Bump allocator over one persistently mapped, host-coherent buffer per frame in flight.
+    // Any thread can take a slice of the current frame with a single atomic add, the whole region
+    // is recycled when the frame loop begins that frame again (Device::BeginFrame).
+    class FrameAllocator
+    {
+    public:
+        FrameAllocator(Device* device, VkDeviceSize sizePerFrame);
+        ~FrameAllocator();
+
+        // Slice of the current frame's buffer, valid until the frame retires. Alignment of 0 uses the
+        // device's minimum uniform / storage buffer offset alignment.
+        BufferSlice Allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+
+        // Makes frameIndex current and empties it, must not race with Allocate (called by BeginFrame).
+        void Reset(uint32_t frameIndex);
+
+        // Bytes taken from the current frame so far.
+        inline VkDeviceSize GetUsedSize() const { return m_Head.load(std::memory_order_relaxed); }
+
+    private:
+        struct FrameBuffer
+        {
+            Buffer buffer;
+            void*  mapped;
+        };
+
+        Device* m_Device;
+
+        VkDeviceSize m_Capacity;
+        VkDeviceSize m_MinAlignment;
+
+        std::array<FrameBuffer, NUM_FRAMES_IN_FLIGHT> m_Frames;
+
+        uint32_t                  m_FrameIndex;
+        std::atomic<VkDeviceSize> m_Head;
+    };
+}
+
+#endif//FRAME_ALLOCATOR
@@ -0,0 +1,68 @@
+#ifndef FRAME_COMMAND_POOLS
+#define FRAME_COMMAND_POOLS
+
+#include <vulkan/vulkan.h>
+#include <VulkanWrappers/Window.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+
+    // One command pool per recording thread and frame in flight, so threads never share a pool.
+    // All pools of a frame are reset in bulk when the frame loop recycles it, and the command buffers
+    // they handed out are reused for the next time the frame comes around.
+    class FrameCommandPools
+    {
+        struct FramePool
+        {
+            VkCommandPool                pool;
+            std::vector<VkCommandBuffer> primaries;
+            std::vector<VkCommandBuffer> secondaries;
+            uint32_t                     usedPrimaries;
+            uint32_t                     usedSecondaries;
+        };
+
+        struct ThreadPools
+        {
+            std::thread::id                             threadId;
+            std::array<FramePool, NUM_FRAMES_IN_FLIGHT> frames;
+        };
+
+    public:
+        FrameCommandPools(const Device* device, uint32_t queueFamilyIndex);
+        ~FrameCommandPools();
+
+        // Recycles every command buffer of the frame, which must have retired on the GPU
+        // and must not be recorded into by any thread while this runs.
+        void Reset(uint32_t frameIndex);
+
+        // Allocates from the calling thread's pool for the frame. Buffers are not begun.
+        VkCommandBuffer Allocate(uint32_t frameIndex, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+        // Queues a recorded primary command buffer to be submitted with the frame, ahead of the frame's
+        // own command buffer. Primaries queued from several threads are submitted in the order queued.
+        void Enqueue(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+
+        // Appends the primaries queued for the frame and clears the queue.
+        void TakeQueued(uint32_t frameIndex, std::vector<VkCommandBuffer>* commandBuffers);
+
+    private:
+        ThreadPools* GetThreadPools();
+
+        const Device* m_Device;
+        uint32_t      m_QueueFamilyIndex;
+        uint64_t      m_Id;
+
+        std::mutex                                                     m_Mutex;
+        std::vector<std::unique_ptr<ThreadPools>>                      m_Threads;
+        std::array<std::vector<VkCommandBuffer>, NUM_FRAMES_IN_FLIGHT> m_Queued;
+    };
+}
+
+#endif//FRAME_COMMAND_POOLS
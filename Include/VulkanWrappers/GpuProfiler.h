@@ -0,0 +1,125 @@
+#ifndef GPU_PROFILER
+#define GPU_PROFILER
+
+#include <vulkan/vulkan.h>
+#include <VulkanWrappers/Window.h>
+
+#include <array>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+
+    // GPU timings of nested scopes recorded into the frame's command buffer, with one set of query pools per frame
+    // in flight. Once registered with Device::SetGpuProfiler, the frame loop (Window / Headless) opens a root
+    // "Frame" scope in NextFrame and closes it in SubmitFrame. The results of a frame slot are read back without
+    // waiting when the slot comes around again, so GetResults() describes the frame NUM_FRAMES_IN_FLIGHT earlier.
+    //
+    // Scopes must be recorded into Frame::commandBuffer (the query pools are reset at its start) and names must
+    // outlive the results (e.g. string literals). With pipeline statistics enabled, they are gathered for the
+    // children of the root scope only, since queries of one type can't be nested.
+    class GpuProfiler
+    {
+    public:
+        struct PipelineStatistics
+        {
+            uint64_t inputAssemblyVertices;
+            uint64_t inputAssemblyPrimitives;
+            uint64_t vertexShaderInvocations;
+            uint64_t clippingInvocations;
+            uint64_t clippingPrimitives;
+            uint64_t fragmentShaderInvocations;
+            uint64_t computeShaderInvocations;
+        };
+
+        // Scopes in recording order (a pre-order walk of the tree), parent is an index into the results.
+        struct Result
+        {
+            const char*        name;
+            uint32_t           parent;
+            uint32_t           depth;
+            double             milliseconds;
+            bool               hasStatistics;
+            PipelineStatistics statistics;
+        };
+
+        class Scope
+        {
+        public:
+            Scope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name)
+                : m_Profiler(profiler), m_CommandBuffer(commandBuffer), m_Index(profiler->BeginScope(commandBuffer, name)) {}
+
+            ~Scope() { m_Profiler->EndScope(m_CommandBuffer, m_Index); }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            GpuProfiler*    m_Profiler;
+            VkCommandBuffer m_CommandBuffer;
+            uint32_t        m_Index;
+        };
+
+        GpuProfiler(Device* device, uint32_t maxScopes = 256, bool pipelineStatistics = false);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        // Called by the frame loop once the frame's command buffer began / before it ends.
+        void BeginFrame(const Frame* frame);
+        void EndFrame(const Frame* frame);
+
+        // Prefer Scope. Returns UINT32_MAX (and records nothing) once the frame ran out of scopes.
+        uint32_t BeginScope(VkCommandBuffer commandBuffer, const char* name);
+        void     EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+        inline const std::vector<Result>& GetResults()      const { return m_Results;      }
+        inline uint64_t                   GetResultsFrame() const { return m_ResultsFrame; }
+
+    private:
+        struct ScopeRecord
+        {
+            const char* name;
+            uint32_t    parent;
+            uint32_t    depth;
+            uint32_t    statisticsQuery;
+        };
+
+        struct FrameQueries
+        {
+            VkQueryPool              timestamps;
+            VkQueryPool              statistics;
+            std::vector<ScopeRecord> scopes;
+            uint32_t                 statisticsCount;
+            uint64_t                 frameNumber;
+            bool                     submitted;
+        };
+
+        void ReadResults(FrameQueries& queries);
+
+        Device*  m_Device;
+        uint32_t m_MaxScopes;
+        bool     m_PipelineStatistics;
+
+        // Nanoseconds per tick, and the bits the queue writes.
+        double   m_TimestampPeriod;
+        uint64_t m_TimestampMask;
+
+        std::array<FrameQueries, NUM_FRAMES_IN_FLIGHT> m_Frames;
+        FrameQueries*                                  m_Current;
+
+        // Open scopes, innermost last.
+        std::vector<uint32_t> m_Stack;
+
+        std::vector<Result> m_Results;
+        uint64_t            m_ResultsFrame;
+
+        // Reused storage for the query results.
+        std::vector<uint64_t> m_Timestamps;
+        std::vector<uint64_t> m_Statistics;
+    };
+}
+
+#endif//GPU_PROFILER
@@ -0,0 +1,63 @@
+#ifndef HEADLESS
+#define HEADLESS
+
+#include <vulkan/vulkan.h>
+
+#include <VulkanWrappers/Window.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/Buffer.h>
+
+#include <array>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+
+    // Window-less counterpart of Window's frame loop for a Device(nullptr).
+    // Every frame in flight renders into its own Image, which SubmitFrame copies into a persistently
+    // mapped readback buffer. Frames are paced on the device's frame timeline like the windowed path,
+    // so the CPU records up to NUM_FRAMES_IN_FLIGHT frames ahead while readbacks complete.
+    class Headless
+    {
+        struct Target
+        {
+            Image       image;
+            Buffer      readback;
+            const void* readbackData;
+
+            // Frame whose pixels land in the readback buffer, 0 when none.
+            uint64_t    frameNumber;
+        };
+
+    public:
+        Headless(Device* device, uint32_t width, uint32_t height, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+        ~Headless();
+
+        // The frame's backBuffer starts out undefined and must be left in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL.
+        bool NextFrame(Device* device, Frame* frame);
+        void SubmitFrame(Device* device, const Frame* frame);
+
+        // Tightly packed pixels of the most recent frame that retired, nullptr until one has.
+        const void* GetReadback(uint64_t* frameNumber = nullptr);
+
+        inline VkViewport GetViewport()    const { return m_Viewport; }
+        inline VkRect2D   GetScissor()     const { return m_Scissor;  }
+        inline VkFormat   GetColorFormat() const { return m_Format;   }
+
+    private:
+        Device*  m_Device;
+        VkFormat m_Format;
+
+        VkViewport m_Viewport;
+        VkRect2D   m_Scissor;
+
+        uint32_t                                 m_FrameIndex;
+        std::array<Target, NUM_FRAMES_IN_FLIGHT> m_Targets;
+
+        // Reused storage for the command buffers gathered at submit.
+        std::vector<VkCommandBuffer> m_SubmitCommandBuffers;
+    };
+}
+
+#endif//HEADLESS
@@ -2,10 +2,12 @@
 #define IMAGE
 
 #include <vulkan/vulkan.h>
-#include <GL/glew.h>
 
 #include <VulkanWrappers/VmaUsage.h>
 
+#include <assert.h>
+#include <vector>
+
 namespace VulkanWrappers
 {
     class Device;
@@ -17,6 +19,9 @@ namespace VulkanWrappers
             VkImageCreateInfo image;
             VkImageViewCreateInfo view;
             VmaAllocationCreateInfo allocation;
+
+            // Also create a view of each mip level (Data::levelViews), e.g. to render into a single level.
+            bool levelViews;
         };
 
         struct Data
@@ -24,25 +29,82 @@ namespace VulkanWrappers
             VkImage image;
             VkImageView view;
             VmaAllocation allocation;
+
+            // One view per mip level when Info::levelViews is set, with the view's layers.
+            std::vector<VkImageView> levelViews;
+
+            // Indices in the device's DescriptorHeap, 0 when the image has no such usage.
+            uint32_t sampledIndex;
+            uint32_t storageIndex;
         };
 
     public:
 
+        // Last known use of a subresource, tracked on the CPU in recording order (see BarrierBatch).
+        struct State
+        {
+            VkImageLayout         layout;
+
+            // Last write, and the stages / accesses a barrier made it visible to since.
+            VkPipelineStageFlags2 writeStage;
+            VkAccessFlags2        writeAccess;
+            VkPipelineStageFlags2 visibleStages;
+            VkAccessFlags2        visibleAccess;
+
+            // Stages that read since the last write, a later write or layout change waits on them.
+            VkPipelineStageFlags2 readStages;
+        };
+
         Image() {}
-        Image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+
+        // Mipmapped images also get transfer usage, for GenerateMips. The view covers every level and layer.
+        Image(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+              uint32_t mipLevels = 1, uint32_t arrayLayers = 1);
+
+        // Length of the full mip chain down to 1x1.
+        static uint32_t GetMipCount(uint32_t width, uint32_t height);
 
         inline Info* GetInfo() { return &m_Info; }
         inline Data* GetData() { return &m_Data; }
 
+        // Only valid for images built with the sized constructor (or after ResetState).
+        inline State* GetState(uint32_t mipLevel, uint32_t arrayLayer)
+        {
+            assert(arrayLayer * m_Info.image.mipLevels + mipLevel < m_State.size());
+            return &m_State[arrayLayer * m_Info.image.mipLevels + mipLevel];
+        }
+
+        // Forgets all tracked usage, every subresource goes back to the image's initial layout.
+        void ResetState();
+
+        // Tracked transition of the whole image in its own barrier, prefer a BarrierBatch for several.
+        static void Transition(VkCommandBuffer commandBuffer, Image* image, VkImageLayout layout, VkPipelineStageFlags2 stage, VkAccessFlags2 access);
+
+        // Fills levels 1+ of every layer by blitting each level into the next, starting from the content of level 0.
+        // Each blit waits on a barrier for the level it reads, then the whole image goes to its next use.
+        static void GenerateMips(VkCommandBuffer commandBuffer, const Device* device, Image* image,
+                                 VkImageLayout layout, VkPipelineStageFlags2 stage, VkAccessFlags2 access);
+
+        // Untracked helpers for raw images such as swapchain back buffers.
         static void TransferUnknownToWrite       (VkCommandBuffer commandBuffer, VkImage vkImage);
         static void TransferWriteToPresent       (VkCommandBuffer commandBuffer, VkImage vkImage);
         static void TransferWriteToSource        (VkCommandBuffer commandBuffer, VkImage vkImage);
         static void TransferUnknownToDestination (VkCommandBuffer commandBuffer, VkImage vkImage);
         static void TransferDestinationToPresent (VkCommandBuffer commandBuffer, VkImage vkImage);
 
+        // Queue family ownership transfer, recorded on the source queue (release) then the destination queue (acquire).
+        // Both halves must use the same layouts. No barrier is needed when both families are the same.
+        static void ReleaseOwnership(VkCommandBuffer commandBuffer, Image* image, uint32_t srcFamily, uint32_t dstFamily, 
+                                     VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+        static void AcquireOwnership(VkCommandBuffer commandBuffer, Image* image, uint32_t srcFamily, uint32_t dstFamily, 
+                                     VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout);
+
     private:
         Data m_Data;
         Info m_Info;
+
+        std::vector<State> m_State;
     };
 }
 
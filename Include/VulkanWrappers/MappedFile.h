@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <stddef.h>
+
+namespace VulkanWrappers
+{
+    // Read-only memory mapping of an entire file.
+    class MappedFile
+    {
+    public:
+        MappedFile() {}
+        MappedFile(const char* filePath);
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        MappedFile(const MappedFile&)            = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Returns false instead of throwing when the file can't be mapped.
+        bool Open(const char* filePath);
+        void Release();
+
+        inline const void* GetData() const { return m_Data;            }
+        inline size_t      GetSize() const { return m_Size;            }
+        inline bool        IsOpen()  const { return m_Data != nullptr; }
+
+    private:
+        const void* m_Data = nullptr;
+        size_t      m_Size = 0;
+
+#ifdef _WIN32
+        void* m_File    = nullptr;
+        void* m_Mapping = nullptr;
+#endif
+    };
+}
+
+#endif//MAPPED_FILE
@@ -0,0 +1,150 @@
+#ifndef RENDER_GRAPH
+#define RENDER_GRAPH
+
+#include <vulkan/vulkan.h>
+
+#include <VulkanWrappers/VmaUsage.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/AliasingPool.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+    class Buffer;
+
+    // Describes a frame as passes that declare the resources they read and write.
+    //
+    // Compile() culls every pass that does not contribute to an imported resource or a pass marked with
+    // a side effect, and places the transient images whose lifetimes (first to last pass using them) do not
+    // overlap on the same device memory (see AliasingPool). Execute() records the surviving passes in
+    // declaration order, each one preceded by a single batched barrier derived from the tracked state of its resources.
+    class RenderGraph
+    {
+    public:
+        typedef uint32_t Resource;
+
+        enum class Access
+        {
+            // Images
+            ColorAttachment,
+            DepthAttachment,
+            DepthRead,
+            Sampled,
+            StorageRead,
+            StorageWrite,
+            TransferSource,
+            TransferDestination,
+            Present,
+
+            // Buffers
+            VertexBuffer,
+            IndexBuffer,
+            IndirectBuffer,
+            UniformBuffer
+        };
+
+        typedef std::function<void(VkCommandBuffer, RenderGraph*)> ExecuteCallback;
+
+        class Pass
+        {
+            friend class RenderGraph;
+
+        public:
+            Pass& Read  (Resource resource, Access access);
+            Pass& Write (Resource resource, Access access);
+
+            // Never culled, e.g. writes to memory the graph does not know about.
+            inline Pass& SetSideEffect() { m_SideEffect = true; return *this; }
+
+        private:
+            struct Use
+            {
+                Resource              resource;
+                VkImageLayout         layout;
+                VkPipelineStageFlags2 stage;
+                VkAccessFlags2        access;
+                VkImageUsageFlags     usage;
+                bool                  write;
+            };
+
+            Pass& Declare(Resource resource, Access access, bool write);
+
+            RenderGraph*     m_Graph;
+            std::string      m_Name;
+            ExecuteCallback  m_Execute;
+            std::vector<Use> m_Uses;
+            bool             m_SideEffect;
+            bool             m_Culled;
+        };
+
+        RenderGraph(Device* device);
+        ~RenderGraph();
+
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        // Graph-owned image, its usage is derived from the passes using it and its contents do not outlive a frame.
+        Resource CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspect);
+
+        // Caller-owned resources, their contents are kept and writes to them are never culled.
+        Resource ImportImage  (Image* image);
+        Resource ImportBuffer (Buffer* buffer);
+
+        // Points an imported handle at another resource, e.g. the target of the current frame in flight.
+        void SetImportedImage  (Resource resource, Image* image);
+        void SetImportedBuffer (Resource resource, Buffer* buffer);
+
+        Pass& AddPass(const char* name, ExecuteCallback execute);
+
+        // Culls passes and (re)creates the transient images, required after adding passes or resources.
+        void Compile();
+
+        void Execute(VkCommandBuffer commandBuffer);
+
+        // Clears all passes and resources, releasing the transient images.
+        void Reset();
+
+        Image*  GetImage  (Resource resource);
+        Buffer* GetBuffer (Resource resource);
+
+        bool IsPassCulled(const char* name) const;
+
+    private:
+        struct ResourceEntry
+        {
+            bool     isBuffer;
+            bool     imported;
+
+            Image*   image;
+            Buffer*  buffer;
+
+            // Transient images only.
+            std::unique_ptr<Image> transient;
+            uint32_t               firstPass;
+            uint32_t               lastPass;
+            uint32_t               aliasEntry;
+        };
+
+        void CullPasses();
+        void CreateTransients();
+        void ReleaseTransients();
+
+        Device* m_Device;
+
+        std::vector<ResourceEntry> m_Resources;
+        std::deque<Pass>           m_Passes;
+
+        // Memory shared by transient images with disjoint lifetimes.
+        AliasingPool m_AliasingPool;
+
+        bool m_Compiled;
+    };
+}
+
+#endif//RENDER_GRAPH
@@ -2,13 +2,14 @@
 #define SHADER
 
 #include <vulkan/vulkan.h>
+#include <VulkanWrappers/MappedFile.h>
 
-#include <stdio.h>
-#include <stdlib.h>
+#include <vector>
 
 namespace VulkanWrappers
 {
     class Device; 
+    class StateCache;
 
     class Shader
     {
@@ -21,22 +22,58 @@ namespace VulkanWrappers
         struct Data
         {
             VkShaderEXT shader;
-            void*       spirvByteCode;
+            MappedFile  spirvFile;
         };
 
     public:
         Shader() {}
+
+        // Memory-maps the SPIR-V file, the mapping is released once the shader object is created.
         Shader(const char* spirvFilePath, VkShaderStageFlagBits stage, VkShaderStageFlags nextStage = 0x0);
 
+        // Uses caller-owned SPIR-V (e.g. an embedded blob or a slice of a pack file) without copying it.
+        // The memory must stay valid until Device::CreateShaders returns.
+        Shader(const void* spirvByteCode, size_t byteCodeSize, VkShaderStageFlagBits stage, VkShaderStageFlags nextStage = 0x0);
+
+        // Drops the reference to the byte code (and unmaps it), called by Device::CreateShaders.
+        void ReleaseByteCode();
+
         static void Bind(VkCommandBuffer commandBuffer, Shader& shader);
 
+        // Skipped when the cache's command buffer already has this shader bound to its stage.
+        static void Bind(StateCache* stateCache, Shader& shader);
+
         inline Info* GetInfo() { return &m_Info; }
         inline Data* GetData() { return &m_Data; }
 
     private:
+        void Initialize(const void* spirvByteCode, size_t byteCodeSize, VkShaderStageFlagBits stage, VkShaderStageFlags nextStage);
+
         Data m_Data;
         Info m_Info;
     };
+
+    // Set of created shaders bound together in one vkCmdBindShadersEXT call. Graphics programs name every graphics
+    // stage of the device, the ones without a shader are bound to VK_NULL_HANDLE so nothing is left over from the
+    // previous program. Compute programs hold a single compute shader. The handles are captured at construction,
+    // rebuild the program if its shaders are recreated.
+    class ShaderProgram
+    {
+    public:
+        ShaderProgram() {}
+        ShaderProgram(const Device* device, const std::vector<Shader*>& shaders);
+
+        static void Bind(VkCommandBuffer commandBuffer, const ShaderProgram& program);
+
+        // Only the stages whose shader differs from the cache's command buffer are bound.
+        static void Bind(StateCache* stateCache, const ShaderProgram& program);
+
+        inline uint32_t GetStageCount() const { return (uint32_t)m_Stages.size(); }
+
+    private:
+        std::vector<VkShaderStageFlagBits> m_Stages;
+        std::vector<VkShaderEXT>           m_Shaders;
+    };
 }
 
 #endif//SHADER
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef SHADER_CACHE
+#define SHADER_CACHE
+
+#include <vulkan/vulkan.h>
+#include <VulkanWrappers/MappedFile.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+
+    // On-disk cache of shader object binaries (VK_SHADER_CODE_TYPE_BINARY_EXT).
+    // Entries are keyed on the SPIR-V, stage, next stage and create flags, and the whole file is tied to
+    // the device's shaderBinaryUUID / shaderBinaryVersion. Linked shaders are also keyed on the rest of their
+    // set, since their binaries depend on the partner stages. The file is memory-mapped and binaries are
+    // handed to the driver straight from the mapping.
+    class ShaderCache
+    {
+        struct Entry
+        {
+            const void* data;
+            size_t      size;
+            uint64_t    checksum;
+            bool        validated;
+        };
+
+    public:
+        ShaderCache(const Device* device, const char* filePath);
+
+        // Replaces the SPIR-V create infos of one vkCreateShadersEXT call with their cached binaries, returns false
+        // when none were found. A linked call is all-or-nothing (binary and SPIR-V stages can't be linked together),
+        // createInfos is left untouched unless every stage hits.
+        bool Find(uint32_t count, const VkShaderCreateInfoEXT* spirvInfos, VkShaderCreateInfoEXT* createInfos);
+
+        // Fetches the binaries of the shader objects of one call that were created from SPIR-V (per createInfos),
+        // to be written on the next Save().
+        void Store(uint32_t count, const VkShaderCreateInfoEXT* spirvInfos, const VkShaderCreateInfoEXT* createInfos, const VkShaderEXT* shaders);
+
+        // Writes all valid entries back to disk.
+        void Save();
+
+    private:
+        void Load();
+
+        // Looks up and validates an entry, the caller holds m_Mutex.
+        const Entry* FindEntry(uint64_t key);
+
+        const Device* m_Device;
+        std::string   m_FilePath;
+
+        uint8_t  m_BinaryUUID[VK_UUID_SIZE];
+        uint32_t m_BinaryVersion;
+
+        MappedFile                                        m_File;
+        std::unordered_map<uint64_t, Entry>               m_Entries;
+        std::unordered_map<uint64_t, std::vector<uint8_t>> m_PendingEntries;
+
+        std::mutex m_Mutex;
+    };
+}
+
+#endif//SHADER_CACHE
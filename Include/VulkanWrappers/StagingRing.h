@@ -0,0 +1,74 @@
+#ifndef STAGING_RING
+#define STAGING_RING
+
+#include <VulkanWrappers/VmaUsage.h>
+#include <VulkanWrappers/Window.h>
+
+#include <array>
+#include <mutex>
+
+namespace VulkanWrappers
+{
+    class Device;
+    class Buffer;
+    class Image;
+
+    // Size of the staging memory owned by each device.
+    #define STAGING_RING_SIZE (64ull * 1024ull * 1024ull)
+
+    // Persistently mapped, host-visible ring of staging memory.
+    // Uploads are sub-allocated from the ring and their copies are recorded into one transfer
+    // command buffer per batch, which is submitted once (typically at the end of the frame).
+    class StagingRing
+    {
+        struct Batch
+        {
+            VkCommandBuffer commandBuffer;
+            VkFence         fence;
+            uint64_t        end;
+            bool            recording;
+            bool            inFlight;
+        };
+
+    public:
+        StagingRing(Device* device, VkDeviceSize size);
+        ~StagingRing();
+
+        // Copies host memory into the buffer, ordered before the next batch submission.
+        void Upload(Buffer* buffer, VkDeviceSize dstOffset, const void* srcPtr, VkDeviceSize size);
+
+        // Copies one tightly packed mip level of one layer (texels, or blocks of blockExtent texels for compressed
+        // formats) into the image, then moves that subresource to layout for every work submitted after the batch.
+        void UploadImage(Image* image, uint32_t mipLevel, uint32_t arrayLayer, VkExtent2D blockExtent,
+                         const void* srcPtr, VkDeviceSize size, VkImageLayout layout);
+
+        // Submits all copies recorded since the last flush.
+        void Flush();
+
+    private:
+        VkDeviceSize Allocate(VkDeviceSize size, VkDeviceSize alignment);
+        Batch&       BeginBatch();
+        bool         RetireOldestBatch();
+        void         SubmitBatch();
+
+        Device*       m_Device;
+        VkBuffer      m_VKBuffer;
+        VmaAllocation m_VMAAllocation;
+        uint8_t*      m_MappedData;
+
+        // Own pool, the device's one is not synchronized against other threads recording.
+        VkCommandPool m_VKCommandPool;
+
+        // Monotonic ring positions (wrapped on use).
+        VkDeviceSize m_Capacity;
+        uint64_t     m_Head;
+        uint64_t     m_Tail;
+
+        uint32_t                                m_BatchIndex;
+        std::array<Batch, NUM_FRAMES_IN_FLIGHT> m_Batches;
+
+        std::mutex m_Mutex;
+    };
+}
+
+#endif//STAGING_RING
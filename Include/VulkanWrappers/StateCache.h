@@ -0,0 +1,115 @@
+#ifndef STATE_CACHE
+#define STATE_CACHE
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    // Complete shader-object dynamic state used by the wrappers' draws.
+    struct RenderState
+    {
+        VkPrimitiveTopology     topology;
+        VkPolygonMode           polygonMode;
+        VkCullModeFlags         cullMode;
+        VkFrontFace             frontFace;
+        VkSampleCountFlagBits   rasterizationSamples;
+        VkSampleMask            sampleMask;
+
+        VkBool32                primitiveRestartEnable;
+        VkBool32                rasterizerDiscardEnable;
+        VkBool32                alphaToCoverageEnable;
+        VkBool32                depthTestEnable;
+        VkBool32                depthWriteEnable;
+        VkBool32                depthBiasEnable;
+        VkBool32                stencilTestEnable;
+
+        // Color attachment 0.
+        VkBool32                blendEnable;
+        VkColorComponentFlags   colorWriteMask;
+        VkColorBlendEquationEXT colorBlendEquation;
+
+        VkViewport              viewport;
+        VkRect2D                scissor;
+
+        // What Device::SetDefaultRenderState used to set.
+        static RenderState Default();
+    };
+
+    // Per-command-buffer tracker of the dynamic state and bound shaders, only the calls whose values differ
+    // from what the command buffer last saw are recorded. Not thread safe, use one per command buffer.
+    class StateCache
+    {
+    public:
+        StateCache() { Begin(VK_NULL_HANDLE); }
+
+        // Starts tracking a command buffer that has no state yet.
+        void Begin(VkCommandBuffer commandBuffer);
+
+        // Forgets what was set, e.g. after executing secondary command buffers.
+        void Invalidate();
+
+        void SetState(const RenderState& state);
+
+        void SetViewport (const VkViewport& viewport);
+        void SetScissor  (const VkRect2D& scissor);
+
+        // Binds the shader objects (VK_NULL_HANDLE unbinds) for the stages that changed, in one call.
+        void BindShaders(uint32_t stageCount, const VkShaderStageFlagBits* stages, const VkShaderEXT* shaders);
+
+        inline VkCommandBuffer    GetCommandBuffer() const { return m_CommandBuffer; }
+        inline const RenderState& GetState()         const { return m_State;         }
+
+    private:
+        // Vertex, tessellation control / evaluation, geometry, fragment, compute, task, mesh.
+        static const uint32_t s_StageCount = 8u;
+
+        enum Field
+        {
+            Topology,
+            PolygonMode,
+            CullMode,
+            FrontFace,
+            RasterizationSamples,
+            SampleMask,
+            PrimitiveRestartEnable,
+            RasterizerDiscardEnable,
+            AlphaToCoverageEnable,
+            DepthTestEnable,
+            DepthWriteEnable,
+            DepthBiasEnable,
+            StencilTestEnable,
+            BlendEnable,
+            ColorWriteMask,
+            ColorBlendEquation,
+            Viewport,
+            Scissor,
+            FieldCount
+        };
+
+        static uint32_t GetStageSlot(VkShaderStageFlagBits stage);
+
+        // True (and the tracked value updated) when the field is unknown or holds another value.
+        template <typename T>
+        bool Differs(Field field, T& current, const T& value);
+
+        VkCommandBuffer m_CommandBuffer;
+
+        RenderState m_State;
+
+        // Bit per Field, set once the command buffer holds the value tracked in m_State.
+        uint32_t    m_KnownFields;
+
+        // Unknown stages (nothing bound through the cache yet) are never skipped.
+        std::array<VkShaderEXT, s_StageCount> m_Shaders;
+        std::array<bool,        s_StageCount> m_HasShader;
+
+        // Reused storage for the stages that changed in BindShaders.
+        std::vector<VkShaderStageFlagBits> m_BindStages;
+        std::vector<VkShaderEXT>           m_BindShaders;
+    };
+}
+
+#endif//STATE_CACHE
@@ -0,0 +1,51 @@
+#ifndef TASK_POOL
+#define TASK_POOL
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    // Minimal fork-join worker pool used to spread resource creation across cores.
+    class TaskPool
+    {
+    public:
+        // The calling thread always takes part, so threadCount - 1 workers are spawned.
+        TaskPool(uint32_t threadCount);
+        ~TaskPool();
+
+        // Runs task(i) for every i in [0, count) and returns once all of them finished.
+        // Tasks must not throw.
+        void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+        inline uint32_t GetThreadCount() const { return (uint32_t)m_Workers.size() + 1u; }
+
+    private:
+        void WorkerLoop();
+        void RunTasks(const std::function<void(uint32_t)>& task, uint32_t count);
+
+        std::vector<std::thread> m_Workers;
+
+        // One ParallelFor at a time.
+        std::mutex m_JobMutex;
+
+        std::mutex              m_Mutex;
+        std::condition_variable m_WakeCondition;
+        std::condition_variable m_DoneCondition;
+
+        const std::function<void(uint32_t)>* m_Task;
+        uint32_t                             m_TaskCount;
+        std::atomic<uint32_t>                m_NextTask;
+        uint32_t                             m_ActiveWorkers;
+        uint64_t                             m_Generation;
+        bool                                 m_Exit;
+    };
+}
+
+#endif//TASK_POOL
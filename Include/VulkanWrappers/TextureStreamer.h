@@ -0,0 +1,86 @@
+#ifndef TEXTURE_STREAMER
+#define TEXTURE_STREAMER
+
+#include <vulkan/vulkan.h>
+#include <VulkanWrappers/Image.h>
+#include <VulkanWrappers/MappedFile.h>
+
+#include <list>
+#include <vector>
+
+namespace VulkanWrappers
+{
+    class Device;
+
+    // Default amount of texture data uploaded by one Update.
+    #define TEXTURE_STREAMER_BUDGET (16ull * 1024ull * 1024ull)
+
+    // Streams KTX2 textures (uncompressed, BCn, ETC2 or ASTC payloads without supercompression) from memory-mapped
+    // files into sampled images through the device's staging ring. Levels are uploaded coarse-to-fine, a little
+    // every frame: each Update brings every pending texture one level further before going finer, so all of them
+    // become usable early. Once a level lands, the image's view (and its descriptor heap index) is rebuilt to
+    // start at the finest resident level.
+    class TextureStreamer
+    {
+    public:
+        class Texture
+        {
+        public:
+            inline Image* GetImage() { return &m_Image; }
+
+            // Sampling is valid once the coarsest level landed, the view only covers the resident levels.
+            inline bool     IsAvailable()      const { return m_ResidentLevel < m_LevelCount; }
+            inline bool     IsResident()       const { return m_ResidentLevel == 0;           }
+            inline uint32_t GetResidentLevel() const { return m_ResidentLevel;                }
+
+        private:
+            friend class TextureStreamer;
+
+            struct Level
+            {
+                VkDeviceSize offset;
+                VkDeviceSize size;
+            };
+
+            Image              m_Image;
+            MappedFile         m_File;
+            std::vector<Level> m_Levels;
+            VkExtent2D         m_BlockExtent;
+            uint32_t           m_LevelCount;
+            uint32_t           m_LayerCount;
+
+            // Finest level uploaded so far, m_LevelCount when none.
+            uint32_t           m_ResidentLevel;
+        };
+
+        TextureStreamer(Device* device);
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        // Maps the file and creates the image, nothing is uploaded until Update. Throws for unsupported files.
+        Texture* Load(const char* filePath);
+
+        // Uploads the coarsest missing levels until the budget is spent (at least one level), submits them
+        // and rebuilds the views of the textures that changed. Call once per frame, before recording draws.
+        void Update(VkDeviceSize byteBudget = TEXTURE_STREAMER_BUDGET);
+
+        void Release(Texture* texture);
+
+        inline bool IsIdle() const { return m_Pending.empty(); }
+
+    private:
+        Device* m_Device;
+
+        // Stable addresses for the handed out textures.
+        std::list<Texture>    m_Textures;
+        std::vector<Texture*> m_Pending;
+
+        // Reused storage for the textures updated by one Update.
+        std::vector<Texture*> m_Updated;
+        std::vector<Image*>   m_UpdatedImages;
+    };
+}
+
+#endif//TEXTURE_STREAMER
@@ -7,6 +7,7 @@
 #endif
 
 #include <vulkan/vulkan.h>
+#include <VulkanWrappers/StateCache.h>
 
 #include <array>
 #include <vector>
@@ -25,6 +26,15 @@ namespace VulkanWrappers
         VkCommandBuffer commandBuffer;
         VkImage         backBuffer;
         VkImageView     backBufferView;
+
+        // Frame-in-flight slot, for per-frame resources (e.g. Device::GetFrameCommandPools()).
+        uint32_t        index;
+
+        // Value the frame signals on Device::GetFrameTimeline() once it retires.
+        uint64_t        number;
+
+        // Dynamic state / bound shaders of commandBuffer, reset by NextFrame.
+        StateCache      stateCache;
     };
 
     class Window
@@ -33,7 +43,7 @@ namespace VulkanWrappers
         Window(const char* name, uint32_t width, uint32_t height);
         ~Window();
 
-        bool NextFrame(const Device* device, Frame* frame);
+        bool NextFrame(Device* device, Frame* frame);
         void SubmitFrame(Device* device, const Frame* frame);
 
         void CreateVulkanSurface   (const Device* device);
@@ -61,16 +71,17 @@ namespace VulkanWrappers
         uint32_t           m_VKSwapchainImageCount;
         uint32_t           m_VKSwapchainImageIndex;
 
-        uint64_t           m_FrameCount;
         uint32_t           m_FrameIndex;
         std::vector<Frame> m_Frames;
 
         // Synchronization Primitives 
         // (these could be merged into Frame but not really useful outside of the render loop). 
-        std::array<VkFence,         NUM_FRAMES_IN_FLIGHT> m_GraphicsQueueCompleteFences;
+        // Frame completion itself is tracked on the device's frame timeline.
         std::array<VkSemaphore,     NUM_FRAMES_IN_FLIGHT> m_GraphicsQueueCompleteSemaphores;  
         std::array<VkSemaphore,     NUM_FRAMES_IN_FLIGHT> m_ImageAcquireSemaphores;
-        std::array<VkCommandBuffer, NUM_FRAMES_IN_FLIGHT> m_VKCommandBuffers;
+
+        // Reused storage for the command buffers gathered at submit.
+        std::vector<VkCommandBuffer> m_SubmitCommandBuffers;
     };
 }
 
@@ -0,0 +1,145 @@
+#include <VulkanWrappers/MappedFile.h>
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+    #if !defined(NOMINMAX)
+        #define NOMINMAX
+    #endif
+
+    #if !defined(WIN32_LEAN_AND_MEAN)
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace VulkanWrappers;
+
+MappedFile::MappedFile(const char* filePath)
+{
+    if (!Open(filePath))
+        throw std::runtime_error("failed to map file.");
+}
+
+MappedFile::~MappedFile()
+{
+    Release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    Release();
+
+    std::swap(m_Data, other.m_Data);
+    std::swap(m_Size, other.m_Size);
+
+#ifdef _WIN32
+    std::swap(m_File,    other.m_File);
+    std::swap(m_Mapping, other.m_Mapping);
+#endif
+
+    return *this;
+}
+
+bool MappedFile::Open(const char* filePath)
+{
+    Release();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize = {};
+
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (data == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_File    = file;
+    m_Mapping = mapping;
+    m_Data    = data;
+    m_Size    = (size_t)fileSize.QuadPart;
+#else
+    int file = open(filePath, O_RDONLY);
+
+    if (file < 0)
+        return false;
+
+    struct stat fileStat = {};
+
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping keeps its own reference to the file.
+    close(file);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    m_Data = data;
+    m_Size = (size_t)fileStat.st_size;
+#endif
+
+    return true;
+}
+
+void MappedFile::Release()
+{
+    if (m_Data == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_Data);
+    CloseHandle(m_Mapping);
+    CloseHandle(m_File);
+
+    m_File    = nullptr;
+    m_Mapping = nullptr;
+#else
+    munmap(const_cast<void*>(m_Data), m_Size);
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
@@ -0,0 +1,458 @@
+#include <VulkanWrappers/RenderGraph.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Buffer.h>
+#include <VulkanWrappers/BarrierBatch.h>
+
+#include <algorithm>
+
+using namespace VulkanWrappers;
+
+static const VkPipelineStageFlags2 s_ShaderStages = VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT |
+                                                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT          |
+                                                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+struct AccessInfo
+{
+    VkImageLayout         layout;
+    VkPipelineStageFlags2 stage;
+    VkAccessFlags2        access;
+    VkImageUsageFlags     imageUsage;
+
+    bool image;
+    bool buffer;
+};
+
+static AccessInfo GetAccessInfo(RenderGraph::Access access)
+{
+    switch (access)
+    {
+        case RenderGraph::Access::ColorAttachment:
+            return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                     VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, false };
+
+        case RenderGraph::Access::DepthAttachment:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                     VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true, false };
+
+        case RenderGraph::Access::DepthRead:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT | s_ShaderStages,
+                     VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, true, false };
+
+        case RenderGraph::Access::Sampled:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, s_ShaderStages,
+                     VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_USAGE_SAMPLED_BIT, true, false };
+
+        case RenderGraph::Access::StorageRead:
+            return { VK_IMAGE_LAYOUT_GENERAL, s_ShaderStages,
+                     VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_IMAGE_USAGE_STORAGE_BIT, true, true };
+
+        case RenderGraph::Access::StorageWrite:
+            return { VK_IMAGE_LAYOUT_GENERAL, s_ShaderStages,
+                     VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_IMAGE_USAGE_STORAGE_BIT, true, true };
+
+        case RenderGraph::Access::TransferSource:
+            return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                     VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, true };
+
+        case RenderGraph::Access::TransferDestination:
+            return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                     VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true, true };
+
+        case RenderGraph::Access::Present:
+            return { VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT,
+                     VK_ACCESS_2_NONE, 0x0, true, false };
+
+        case RenderGraph::Access::VertexBuffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                     VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, 0x0, false, true };
+
+        case RenderGraph::Access::IndexBuffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+                     VK_ACCESS_2_INDEX_READ_BIT, 0x0, false, true };
+
+        case RenderGraph::Access::IndirectBuffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                     VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, 0x0, false, true };
+
+        case RenderGraph::Access::UniformBuffer:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, s_ShaderStages,
+                     VK_ACCESS_2_UNIFORM_READ_BIT, 0x0, false, true };
+    }
+
+    throw std::runtime_error("unknown render graph access.");
+}
+
+// Pass
+// ------------------------------------------
+
+RenderGraph::Pass& RenderGraph::Pass::Read(Resource resource, Access access)
+{
+    return Declare(resource, access, false);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Write(Resource resource, Access access)
+{
+    return Declare(resource, access, true);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Declare(Resource resource, Access access, bool write)
+{
+    if (resource >= m_Graph->m_Resources.size())
+        throw std::runtime_error("invalid render graph resource.");
+
+    auto info     = GetAccessInfo(access);
+    bool isBuffer = m_Graph->m_Resources[resource].isBuffer;
+
+    if ((isBuffer && !info.buffer) || (!isBuffer && !info.image))
+        throw std::runtime_error("render graph access does not apply to the resource type.");
+
+    // Several uses of one resource in a pass are merged so it only needs one barrier.
+    for (auto& use : m_Uses)
+    {
+        if (use.resource != resource)
+            continue;
+
+        if (!isBuffer && use.layout != info.layout)
+            throw std::runtime_error("render graph pass uses an image in two layouts.");
+
+        use.stage  |= info.stage;
+        use.access |= info.access;
+        use.usage  |= info.imageUsage;
+        use.write  |= write;
+
+        return *this;
+    }
+
+    Use use = {};
+    use.resource = resource;
+    use.layout   = info.layout;
+    use.stage    = info.stage;
+    use.access   = info.access;
+    use.usage    = info.imageUsage;
+    use.write    = write;
+
+    m_Uses.push_back(use);
+
+    m_Graph->m_Compiled = false;
+
+    return *this;
+}
+
+// Graph
+// ------------------------------------------
+
+RenderGraph::RenderGraph(Device* device)
+    : m_Device(device), m_AliasingPool(device), m_Compiled(false)
+{}
+
+RenderGraph::~RenderGraph()
+{
+    ReleaseTransients();
+}
+
+RenderGraph::Resource RenderGraph::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageAspectFlags aspect)
+{
+    ResourceEntry entry = {};
+    entry.isBuffer  = false;
+    entry.imported  = false;
+    entry.transient = std::make_unique<Image>(width, height, format, 0x0, aspect);
+    entry.image     = entry.transient.get();
+
+    m_Resources.push_back(std::move(entry));
+    m_Compiled = false;
+
+    return (Resource)m_Resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::ImportImage(Image* image)
+{
+    ResourceEntry entry = {};
+    entry.isBuffer = false;
+    entry.imported = true;
+    entry.image    = image;
+
+    m_Resources.push_back(std::move(entry));
+    m_Compiled = false;
+
+    return (Resource)m_Resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::ImportBuffer(Buffer* buffer)
+{
+    ResourceEntry entry = {};
+    entry.isBuffer = true;
+    entry.imported = true;
+    entry.buffer   = buffer;
+
+    m_Resources.push_back(std::move(entry));
+    m_Compiled = false;
+
+    return (Resource)m_Resources.size() - 1;
+}
+
+void RenderGraph::SetImportedImage(Resource resource, Image* image)
+{
+    if (!m_Resources[resource].imported || m_Resources[resource].isBuffer)
+        throw std::runtime_error("render graph resource is not an imported image.");
+
+    m_Resources[resource].image = image;
+}
+
+void RenderGraph::SetImportedBuffer(Resource resource, Buffer* buffer)
+{
+    if (!m_Resources[resource].imported || !m_Resources[resource].isBuffer)
+        throw std::runtime_error("render graph resource is not an imported buffer.");
+
+    m_Resources[resource].buffer = buffer;
+}
+
+RenderGraph::Pass& RenderGraph::AddPass(const char* name, ExecuteCallback execute)
+{
+    m_Passes.emplace_back();
+
+    auto& pass = m_Passes.back();
+    pass.m_Graph      = this;
+    pass.m_Name       = name;
+    pass.m_Execute    = std::move(execute);
+    pass.m_SideEffect = false;
+    pass.m_Culled     = false;
+
+    m_Compiled = false;
+
+    return pass;
+}
+
+void RenderGraph::Compile()
+{
+    CullPasses();
+
+    ReleaseTransients();
+    CreateTransients();
+
+    m_Compiled = true;
+}
+
+void RenderGraph::CullPasses()
+{
+    // Reference counting: a pass stays while something still consumes one of its writes,
+    // imported resources count as consumed by whatever comes after the graph.
+    std::vector<uint32_t> passRefs    (m_Passes.size(),    0u);
+    std::vector<uint32_t> resourceRefs(m_Resources.size(), 0u);
+
+    for (uint32_t resource = 0; resource < m_Resources.size(); ++resource)
+    {
+        if (m_Resources[resource].imported)
+            resourceRefs[resource]++;
+    }
+
+    for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+    {
+        auto& pass = m_Passes[passIndex];
+        pass.m_Culled = false;
+
+        for (auto& use : pass.m_Uses)
+        {
+            if (use.write)
+                passRefs[passIndex]++;
+            else
+                resourceRefs[use.resource]++;
+        }
+    }
+
+    std::vector<uint32_t> unreferenced;
+
+    auto CullPass = [&](uint32_t passIndex)
+    {
+        m_Passes[passIndex].m_Culled = true;
+
+        for (auto& use : m_Passes[passIndex].m_Uses)
+        {
+            if (!use.write && --resourceRefs[use.resource] == 0)
+                unreferenced.push_back(use.resource);
+        }
+    };
+
+    for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+    {
+        if (passRefs[passIndex] == 0 && !m_Passes[passIndex].m_SideEffect)
+            CullPass(passIndex);
+    }
+
+    for (uint32_t resource = 0; resource < m_Resources.size(); ++resource)
+    {
+        if (resourceRefs[resource] == 0)
+            unreferenced.push_back(resource);
+    }
+
+    while (!unreferenced.empty())
+    {
+        Resource resource = unreferenced.back();
+        unreferenced.pop_back();
+
+        // Nobody reads the resource anymore, its writers lose a reference.
+        for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+        {
+            auto& pass = m_Passes[passIndex];
+
+            if (pass.m_Culled || pass.m_SideEffect)
+                continue;
+
+            for (auto& use : pass.m_Uses)
+            {
+                if (use.resource == resource && use.write && --passRefs[passIndex] == 0)
+                    CullPass(passIndex);
+            }
+        }
+    }
+}
+
+void RenderGraph::CreateTransients()
+{
+    const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+    for (uint32_t resource = 0; resource < m_Resources.size(); ++resource)
+    {
+        auto& entry = m_Resources[resource];
+
+        if (entry.transient == nullptr)
+            continue;
+
+        // Lifetime and usage over the passes that survived culling.
+        entry.firstPass = UINT32_MAX;
+        entry.lastPass  = 0;
+
+        VkImageUsageFlags usage = 0x0;
+
+        for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+        {
+            auto& pass = m_Passes[passIndex];
+
+            if (pass.m_Culled)
+                continue;
+
+            for (auto& use : pass.m_Uses)
+            {
+                if (use.resource != resource)
+                    continue;
+
+                entry.firstPass = std::min(entry.firstPass, passIndex);
+                entry.lastPass  = std::max(entry.lastPass,  passIndex);
+
+                usage |= use.usage;
+            }
+        }
+
+        if (entry.firstPass == UINT32_MAX)
+            continue;
+
+        // Attachments that are never sampled or copied can live in lazily allocated memory.
+        if (m_AliasingPool.SupportsLazyAllocation() && (usage & ~attachmentUsage) == 0)
+            usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+        entry.transient->GetInfo()->image.usage = usage;
+        entry.aliasEntry = m_AliasingPool.Add(entry.transient.get(), entry.firstPass, entry.lastPass);
+    }
+
+    m_AliasingPool.Build();
+}
+
+void RenderGraph::ReleaseTransients()
+{
+    m_AliasingPool.Release();
+}
+
+void RenderGraph::Execute(VkCommandBuffer commandBuffer)
+{
+    if (!m_Compiled)
+        throw std::runtime_error("render graph must be compiled before execution.");
+
+    for (uint32_t passIndex = 0; passIndex < m_Passes.size(); ++passIndex)
+    {
+        auto& pass = m_Passes[passIndex];
+
+        if (pass.m_Culled)
+            continue;
+
+        BarrierBatch barriers(commandBuffer);
+
+        // First use of transients this frame: the contents are discarded, but the memory may still be in use by
+        // its previous occupant (possibly this image last frame), which a memory barrier orders before this pass.
+        // Those barriers can't order the layout transitions recorded with them, so they go first, and each image
+        // then transitions from UNDEFINED waiting only on the stage the memory was handed to.
+        bool aliased = false;
+
+        for (auto& use : pass.m_Uses)
+        {
+            auto& entry = m_Resources[use.resource];
+
+            if (entry.isBuffer || entry.transient == nullptr || entry.firstPass != passIndex)
+                continue;
+
+            // Transient images have a single subresource.
+            auto lastOccupant = m_AliasingPool.Claim(entry.aliasEntry);
+
+            Image::State previous = {};
+
+            if (lastOccupant != nullptr)
+                previous = *lastOccupant->GetState(0, 0);
+
+            entry.image->ResetState();
+
+            if (previous.writeStage == VK_PIPELINE_STAGE_2_NONE && previous.readStages == VK_PIPELINE_STAGE_2_NONE)
+                continue;
+
+            barriers.GlobalBarrier(previous.writeStage | previous.readStages, previous.writeAccess, use.stage, use.access);
+            entry.image->GetState(0, 0)->writeStage = use.stage;
+
+            aliased = true;
+        }
+
+        if (aliased)
+            barriers.Flush();
+
+        for (auto& use : pass.m_Uses)
+        {
+            auto& entry = m_Resources[use.resource];
+
+            if (entry.isBuffer)
+                barriers.Transition(entry.buffer, use.stage, use.access);
+            else
+                barriers.Transition(entry.image, use.layout, use.stage, use.access);
+        }
+
+        barriers.Flush();
+
+        pass.m_Execute(commandBuffer, this);
+    }
+}
+
+void RenderGraph::Reset()
+{
+    ReleaseTransients();
+
+    m_Passes.clear();
+    m_Resources.clear();
+
+    m_Compiled = false;
+}
+
+Image* RenderGraph::GetImage(Resource resource)
+{
+    return m_Resources[resource].isBuffer ? nullptr : m_Resources[resource].image;
+}
+
+Buffer* RenderGraph::GetBuffer(Resource resource)
+{
+    return m_Resources[resource].isBuffer ? m_Resources[resource].buffer : nullptr;
+}
+
+bool RenderGraph::IsPassCulled(const char* name) const
+{
+    for (auto& pass : m_Passes)
+    {
+        if (pass.m_Name == name)
+            return pass.m_Culled;
+    }
+
+    return false;
+}
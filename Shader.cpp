@@ -1,5 +1,6 @@
 #include <VulkanWrappers/Shader.h>
 #include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/StateCache.h>
 
 #include <iostream>
 
@@ -7,41 +8,29 @@ using namespace VulkanWrappers;
 
 Shader::Shader(const char* spirvFilePath, VkShaderStageFlagBits stage, VkShaderStageFlags nextStage)
 {
-    // Read byte code from file.
+    // Map byte code from file.
     // -------------------
 
-    FILE* file = fopen(spirvFilePath, "rb");
+    if (!m_Data.spirvFile.Open(spirvFilePath))
+        throw std::runtime_error("failed to read shader byte code.");
 
-    if (!file)
-        throw std::runtime_error("failed to open shader byte code.");
-
-    // Determine the byte code file size.
-
-    fseek(file, 0, SEEK_END);
-    long byteCodeSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    // Allocate the byteCode memory. 
-    m_Data.spirvByteCode = malloc(byteCodeSize + 1);
-
-    if (!m_Data.spirvByteCode)
-        throw std::runtime_error("failed to allocate memory for shader bytecode.");
-
-    // Read in the file to memory.
-    size_t result = fread(m_Data.spirvByteCode, 1, byteCodeSize, file);
+    Initialize(m_Data.spirvFile.GetData(), m_Data.spirvFile.GetSize(), stage, nextStage);
+}
 
-    if (result != byteCodeSize)
-    {
-        printf("failed to read bytecode.");
-        free(m_Data.spirvByteCode);
-        fclose(file);
-    }
+Shader::Shader(const void* spirvByteCode, size_t byteCodeSize, VkShaderStageFlagBits stage, VkShaderStageFlags nextStage)
+{
+    Initialize(spirvByteCode, byteCodeSize, stage, nextStage);
+}
 
-    // Close file. 
-    fclose(file);
+void Shader::Initialize(const void* spirvByteCode, size_t byteCodeSize, VkShaderStageFlagBits stage, VkShaderStageFlags nextStage)
+{
+    if (spirvByteCode == nullptr || byteCodeSize == 0 || byteCodeSize % sizeof(uint32_t) != 0)
+        throw std::runtime_error("invalid shader byte code.");
 
     // VK Shader Object Info
     // -------------------
+    m_Data.shader = VK_NULL_HANDLE;
+
     m_Info = {};
     m_Info.stages = stage;
 
@@ -52,15 +41,24 @@ Shader::Shader(const char* spirvFilePath, VkShaderStageFlagBits stage, VkShaderS
     m_Info.shader.stage                  = stage;
     m_Info.shader.nextStage              = nextStage;
     m_Info.shader.codeType               = VK_SHADER_CODE_TYPE_SPIRV_EXT;
-    m_Info.shader.codeSize               = (size_t)byteCodeSize;
-    m_Info.shader.pCode                  = m_Data.spirvByteCode;
+    m_Info.shader.codeSize               = byteCodeSize;
+    m_Info.shader.pCode                  = spirvByteCode;
     m_Info.shader.pName                  = "main";
+
+    // Layout is filled in with the device's binding model by Device::CreateShaders.
     m_Info.shader.setLayoutCount         = 0;
     m_Info.shader.pSetLayouts            = nullptr;
     m_Info.shader.pushConstantRangeCount = 0;
     m_Info.shader.pPushConstantRanges    = nullptr;
     m_Info.shader.pSpecializationInfo    = nullptr;
+}
+
+void Shader::ReleaseByteCode()
+{
+    m_Info.shader.pCode    = nullptr;
+    m_Info.shader.codeSize = 0;
 
+    m_Data.spirvFile.Release();
 }
 
 void Shader::Bind(VkCommandBuffer commandBuffer, Shader& shader)
@@ -68,4 +66,79 @@ void Shader::Bind(VkCommandBuffer commandBuffer, Shader& shader)
     auto shaderObject = shader.GetData()->shader;
     auto shaderStage  = shader.GetInfo()->stages;
     Device::vkCmdBindShadersEXT(commandBuffer, 1u, &shaderStage, &shaderObject);
+}
+
+void Shader::Bind(StateCache* stateCache, Shader& shader)
+{
+    auto shaderObject = shader.GetData()->shader;
+    auto shaderStage  = shader.GetInfo()->stages;
+    stateCache->BindShaders(1u, &shaderStage, &shaderObject);
+}
+
+ShaderProgram::ShaderProgram(const Device* device, const std::vector<Shader*>& shaders)
+{
+    VkShaderStageFlags programStages = 0x0;
+
+    for (auto shader : shaders)
+    {
+        auto stage = shader->GetInfo()->stages;
+
+        if (shader->GetData()->shader == VK_NULL_HANDLE)
+            throw std::runtime_error("shader program needs created shaders.");
+
+        if (programStages & stage)
+            throw std::runtime_error("shader program has more than one shader for a stage.");
+
+        programStages |= stage;
+    }
+
+    if (programStages & VK_SHADER_STAGE_COMPUTE_BIT)
+    {
+        if (programStages != VK_SHADER_STAGE_COMPUTE_BIT)
+            throw std::runtime_error("compute shader programs can't have other stages.");
+
+        m_Stages.push_back(VK_SHADER_STAGE_COMPUTE_BIT);
+        m_Shaders.push_back(shaders[0]->GetData()->shader);
+
+        return;
+    }
+
+    if (programStages & ~device->GetGraphicsShaderStages())
+        throw std::runtime_error("shader program uses a stage the device does not enable.");
+
+    static const VkShaderStageFlagBits s_GraphicsStages[] =
+    {
+        VK_SHADER_STAGE_VERTEX_BIT,
+        VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
+        VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+        VK_SHADER_STAGE_GEOMETRY_BIT,
+        VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+
+    for (auto stage : s_GraphicsStages)
+    {
+        if (!(device->GetGraphicsShaderStages() & stage))
+            continue;
+
+        VkShaderEXT shaderObject = VK_NULL_HANDLE;
+
+        for (auto shader : shaders)
+        {
+            if (shader->GetInfo()->stages == stage)
+                shaderObject = shader->GetData()->shader;
+        }
+
+        m_Stages.push_back(stage);
+        m_Shaders.push_back(shaderObject);
+    }
+}
+
+void ShaderProgram::Bind(VkCommandBuffer commandBuffer, const ShaderProgram& program)
+{
+    Device::vkCmdBindShadersEXT(commandBuffer, program.GetStageCount(), program.m_Stages.data(), program.m_Shaders.data());
+}
+
+void ShaderProgram::Bind(StateCache* stateCache, const ShaderProgram& program)
+{
+    stateCache->BindShaders(program.GetStageCount(), program.m_Stages.data(), program.m_Shaders.data());
 }
\ No newline at end of file
@@ -0,0 +1,402 @@
+#include <VulkanWrappers/ShaderCache.h>
+#include <VulkanWrappers/Device.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #if !defined(NOMINMAX)
+        #define NOMINMAX
+    #endif
+
+    #if !defined(WIN32_LEAN_AND_MEAN)
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+
+    #include <windows.h>
+#endif
+
+using namespace VulkanWrappers;
+
+// File Layout
+// ----------------------------------------
+
+#define SHADER_CACHE_MAGIC     0x53435756u // "VWCS"
+#define SHADER_CACHE_VERSION   3u
+
+// Binary shader code must be 16-byte aligned.
+#define SHADER_CACHE_ALIGNMENT 16ull
+
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint8_t  binaryUUID[VK_UUID_SIZE];
+    uint32_t binaryVersion;
+    uint32_t entryCount;
+};
+
+struct FileEntry
+{
+    uint64_t key;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+// Hashing (FNV-1a)
+// ----------------------------------------
+
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+template <typename T>
+static uint64_t HashValue(uint64_t hash, const T& value)
+{
+    return HashBytes(&value, sizeof(T), hash);
+}
+
+static uint64_t ComputeKey(const VkShaderCreateInfoEXT& info)
+{
+    uint64_t key = HashBytes(info.pCode, info.codeSize);
+
+    key = HashValue(key, info.codeSize);
+    key = HashValue(key, info.stage);
+    key = HashValue(key, info.nextStage);
+    key = HashValue(key, info.flags);
+    key = HashBytes(info.pName, strlen(info.pName), key);
+
+    // Binaries are tied to the interface they were created with.
+    key = HashValue(key, info.setLayoutCount);
+
+    for (uint32_t i = 0; i < info.pushConstantRangeCount; ++i)
+        key = HashValue(key, info.pPushConstantRanges[i]);
+
+    // Specialization constants are folded into the binary.
+    if (info.pSpecializationInfo != nullptr)
+    {
+        auto specialization = info.pSpecializationInfo;
+
+        key = HashValue(key, specialization->mapEntryCount);
+
+        for (uint32_t i = 0; i < specialization->mapEntryCount; ++i)
+        {
+            key = HashValue(key, specialization->pMapEntries[i].constantID);
+            key = HashValue(key, specialization->pMapEntries[i].offset);
+            key = HashValue(key, specialization->pMapEntries[i].size);
+        }
+
+        key = HashValue(key, specialization->dataSize);
+        key = HashBytes(specialization->pData, specialization->dataSize, key);
+    }
+
+    return key;
+}
+
+// Keys of every create info of one call. Linked shaders also hash the whole set, so a binary linked
+// against other partner stages is never reused.
+static void ComputeKeys(uint32_t count, const VkShaderCreateInfoEXT* infos, std::vector<uint64_t>* keys)
+{
+    keys->resize(count);
+
+    uint64_t setKey = 0xCBF29CE484222325ull;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        (*keys)[i] = ComputeKey(infos[i]);
+
+        if (infos[i].flags & VK_SHADER_CREATE_LINK_STAGE_BIT_EXT)
+            setKey = HashValue(setKey, (*keys)[i]);
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (infos[i].flags & VK_SHADER_CREATE_LINK_STAGE_BIT_EXT)
+            (*keys)[i] = HashValue((*keys)[i], setKey);
+    }
+}
+
+static bool IsLinked(uint32_t count, const VkShaderCreateInfoEXT* infos)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (infos[i].flags & VK_SHADER_CREATE_LINK_STAGE_BIT_EXT)
+            return true;
+    }
+
+    return false;
+}
+
+// Atomically swaps the written file in, readers see either the old or the new cache.
+static bool ReplaceFile(const char* srcPath, const char* dstPath)
+{
+#ifdef _WIN32
+    return MoveFileExA(srcPath, dstPath, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(srcPath, dstPath) == 0;
+#endif
+}
+
+// Implementation
+// ----------------------------------------
+
+ShaderCache::ShaderCache(const Device* device, const char* filePath)
+    : m_Device(device), m_FilePath(filePath)
+{
+    // Binaries are only valid for the exact same driver binary format.
+    VkPhysicalDeviceShaderObjectPropertiesEXT shaderObjectProperties = {};
+    shaderObjectProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 properties = {};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &shaderObjectProperties;
+
+    vkGetPhysicalDeviceProperties2(device->GetPhysical(), &properties);
+
+    memcpy(m_BinaryUUID, shaderObjectProperties.shaderBinaryUUID, VK_UUID_SIZE);
+    m_BinaryVersion = shaderObjectProperties.shaderBinaryVersion;
+
+    Load();
+}
+
+void ShaderCache::Load()
+{
+    m_Entries.clear();
+
+    // A missing cache is not an error, it's just a cold start.
+    if (!m_File.Open(m_FilePath.c_str()))
+        return;
+
+    auto   fileData = static_cast<const uint8_t*>(m_File.GetData());
+    size_t fileSize = m_File.GetSize();
+
+    if (fileSize < sizeof(FileHeader))
+    {
+        m_File.Release();
+        return;
+    }
+
+    FileHeader header;
+    memcpy(&header, fileData, sizeof(FileHeader));
+
+    if (header.magic         != SHADER_CACHE_MAGIC   ||
+        header.version       != SHADER_CACHE_VERSION ||
+        header.binaryVersion != m_BinaryVersion      ||
+        memcmp(header.binaryUUID, m_BinaryUUID, VK_UUID_SIZE) != 0 ||
+        sizeof(FileHeader) + (uint64_t)header.entryCount * sizeof(FileEntry) > fileSize)
+    {
+        m_File.Release();
+        return;
+    }
+
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        FileEntry entry;
+        memcpy(&entry, fileData + sizeof(FileHeader) + i * sizeof(FileEntry), sizeof(FileEntry));
+
+        // Skip anything pointing outside the file, the shader will come from SPIR-V instead.
+        if (entry.offset % SHADER_CACHE_ALIGNMENT != 0 || entry.size == 0 || entry.offset + entry.size > fileSize)
+            continue;
+
+        m_Entries[entry.key] = { fileData + entry.offset, (size_t)entry.size, entry.checksum, false };
+    }
+}
+
+const ShaderCache::Entry* ShaderCache::FindEntry(uint64_t key)
+{
+    auto entry = m_Entries.find(key);
+
+    if (entry == m_Entries.end())
+        return nullptr;
+
+    // Validate lazily so a large cache doesn't need to be read in full on startup.
+    if (!entry->second.validated)
+    {
+        if (HashBytes(entry->second.data, entry->second.size) != entry->second.checksum)
+        {
+            m_Entries.erase(entry);
+            return nullptr;
+        }
+
+        entry->second.validated = true;
+    }
+
+    return &entry->second;
+}
+
+bool ShaderCache::Find(uint32_t count, const VkShaderCreateInfoEXT* spirvInfos, VkShaderCreateInfoEXT* createInfos)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (spirvInfos[i].codeType != VK_SHADER_CODE_TYPE_SPIRV_EXT)
+            return false;
+    }
+
+    std::vector<uint64_t> keys;
+    ComputeKeys(count, spirvInfos, &keys);
+
+    bool linked = IsLinked(count, spirvInfos);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    std::vector<const Entry*> entries(count);
+
+    uint32_t hits = 0;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        entries[i] = FindEntry(keys[i]);
+
+        if (entries[i] != nullptr)
+            hits++;
+    }
+
+    if (hits == 0 || (linked && hits != count))
+        return false;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (entries[i] == nullptr)
+            continue;
+
+        createInfos[i] = spirvInfos[i];
+        createInfos[i].codeType = VK_SHADER_CODE_TYPE_BINARY_EXT;
+        createInfos[i].codeSize = entries[i]->size;
+        createInfos[i].pCode    = entries[i]->data;
+    }
+
+    return true;
+}
+
+void ShaderCache::Store(uint32_t count, const VkShaderCreateInfoEXT* spirvInfos, const VkShaderCreateInfoEXT* createInfos, const VkShaderEXT* shaders)
+{
+    std::vector<uint64_t> keys;
+    ComputeKeys(count, spirvInfos, &keys);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (createInfos[i].codeType != VK_SHADER_CODE_TYPE_SPIRV_EXT)
+            continue;
+
+        size_t binarySize = 0;
+
+        if (Device::vkGetShaderBinaryDataEXT(m_Device->GetLogical(), shaders[i], &binarySize, nullptr) != VK_SUCCESS || binarySize == 0)
+            continue;
+
+        std::vector<uint8_t> binary(binarySize);
+
+        if (Device::vkGetShaderBinaryDataEXT(m_Device->GetLogical(), shaders[i], &binarySize, binary.data()) != VK_SUCCESS)
+            continue;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_PendingEntries[keys[i]] = std::move(binary);
+    }
+}
+
+void ShaderCache::Save()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_PendingEntries.empty())
+        return;
+
+    struct Blob
+    {
+        uint64_t    key;
+        const void* data;
+        size_t      size;
+    };
+
+    std::vector<Blob> blobs;
+
+    for (auto& entry : m_Entries)
+    {
+        // Newly fetched binaries replace any stale entries with the same key.
+        if (m_PendingEntries.find(entry.first) == m_PendingEntries.end())
+            blobs.push_back({ entry.first, entry.second.data, entry.second.size });
+    }
+
+    for (auto& entry : m_PendingEntries)
+        blobs.push_back({ entry.first, entry.second.data(), entry.second.size() });
+
+    // Layout
+    // -------------------
+
+    std::vector<FileEntry> fileEntries(blobs.size());
+
+    uint64_t offset = sizeof(FileHeader) + blobs.size() * sizeof(FileEntry);
+
+    for (size_t i = 0; i < blobs.size(); ++i)
+    {
+        offset = (offset + SHADER_CACHE_ALIGNMENT - 1) & ~(SHADER_CACHE_ALIGNMENT - 1);
+
+        fileEntries[i].key      = blobs[i].key;
+        fileEntries[i].offset   = offset;
+        fileEntries[i].size     = blobs[i].size;
+        fileEntries[i].checksum = HashBytes(blobs[i].data, blobs[i].size);
+
+        offset += blobs[i].size;
+    }
+
+    FileHeader header = {};
+    header.magic         = SHADER_CACHE_MAGIC;
+    header.version       = SHADER_CACHE_VERSION;
+    header.binaryVersion = m_BinaryVersion;
+    header.entryCount    = (uint32_t)blobs.size();
+    memcpy(header.binaryUUID, m_BinaryUUID, VK_UUID_SIZE);
+
+    // Write
+    // -------------------
+
+    // Write beside the cache and swap it in, so an interrupted save never leaves a torn file behind.
+    std::string tempPath = m_FilePath + ".tmp";
+
+    FILE* file = fopen(tempPath.c_str(), "wb");
+
+    if (!file)
+        throw std::runtime_error("failed to open shader cache for writing.");
+
+    bool written = fwrite(&header, sizeof(FileHeader), 1, file) == 1;
+
+    if (!fileEntries.empty())
+        written &= fwrite(fileEntries.data(), sizeof(FileEntry), fileEntries.size(), file) == fileEntries.size();
+
+    static const uint8_t s_Padding[SHADER_CACHE_ALIGNMENT] = {};
+
+    for (size_t i = 0; i < blobs.size(); ++i)
+    {
+        long position = ftell(file);
+
+        written &= fwrite(s_Padding, 1, fileEntries[i].offset - position, file) == fileEntries[i].offset - position;
+        written &= fwrite(blobs[i].data, 1, blobs[i].size, file) == blobs[i].size;
+    }
+
+    fclose(file);
+
+    if (!written)
+    {
+        remove(tempPath.c_str());
+        throw std::runtime_error("failed to write shader cache.");
+    }
+
+    // Existing entries point into the mapping, it can only be released once they are written.
+    m_Entries.clear();
+    m_File.Release();
+    m_PendingEntries.clear();
+
+    if (!ReplaceFile(tempPath.c_str(), m_FilePath.c_str()))
+        throw std::runtime_error("failed to replace shader cache.");
+
+    Load();
+}
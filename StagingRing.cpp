@@ -0,0 +1,370 @@
+#include <VulkanWrappers/StagingRing.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/Buffer.h>
+#include <VulkanWrappers/Image.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace VulkanWrappers;
+
+// Keep every staged region aligned for the widest copies we issue.
+#define STAGING_ALIGNMENT 16ull
+
+StagingRing::StagingRing(Device* device, VkDeviceSize size)
+    : m_Device(device), m_Capacity(size), m_Head(0), m_Tail(0), m_BatchIndex(0)
+{
+    // Persistently mapped staging memory.
+    // ----------------------
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size        = size;
+    bufferInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocationInfo = {};
+    allocationInfo.usage = VMA_MEMORY_USAGE_AUTO;
+    allocationInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocationResult = {};
+
+    if (vmaCreateBuffer(device->GetAllocator(), &bufferInfo, &allocationInfo, &m_VKBuffer, &m_VMAAllocation, &allocationResult) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate staging ring.");
+
+    m_MappedData = static_cast<uint8_t*>(allocationResult.pMappedData);
+
+    // Batches
+    // ----------------------
+
+    VkCommandPoolCreateInfo commandPoolInfo = {};
+    commandPoolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolInfo.queueFamilyIndex = device->GetGraphicsQueueFamily();
+
+    if (vkCreateCommandPool(device->GetLogical(), &commandPoolInfo, nullptr, &m_VKCommandPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create staging command pool.");
+
+    for (auto& batch : m_Batches)
+    {
+        batch = {};
+
+        VkCommandBufferAllocateInfo commandAllocateInfo = {};
+        commandAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandAllocateInfo.commandPool        = m_VKCommandPool;
+        commandAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandAllocateInfo.commandBufferCount = 1u;
+
+        if (vkAllocateCommandBuffers(device->GetLogical(), &commandAllocateInfo, &batch.commandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate staging command buffer.");
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        if (vkCreateFence(device->GetLogical(), &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+            throw std::runtime_error("failed to create staging fence.");
+    }
+}
+
+StagingRing::~StagingRing()
+{
+    for (auto& batch : m_Batches)
+    {
+        if (batch.inFlight)
+            vkWaitForFences(m_Device->GetLogical(), 1u, &batch.fence, VK_TRUE, UINT64_MAX);
+
+        vkDestroyFence(m_Device->GetLogical(), batch.fence, nullptr);
+    }
+
+    // Frees the batches' command buffers.
+    vkDestroyCommandPool(m_Device->GetLogical(), m_VKCommandPool, nullptr);
+
+    vmaDestroyBuffer(m_Device->GetAllocator(), m_VKBuffer, m_VMAAllocation);
+}
+
+void StagingRing::Upload(Buffer* buffer, VkDeviceSize dstOffset, const void* srcPtr, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Larger uploads are split so that one call can never wait on its own copies.
+    const VkDeviceSize maxChunkSize = m_Capacity / 2;
+
+    auto src = static_cast<const uint8_t*>(srcPtr);
+
+    while (size > 0)
+    {
+        VkDeviceSize chunkSize = std::min(size, maxChunkSize);
+        VkDeviceSize offset    = Allocate(chunkSize, STAGING_ALIGNMENT);
+
+        memcpy(m_MappedData + offset, src, chunkSize);
+
+        VkBufferCopy region = {};
+        region.srcOffset = offset;
+        region.dstOffset = dstOffset;
+        region.size      = chunkSize;
+
+        vkCmdCopyBuffer(BeginBatch().commandBuffer, m_VKBuffer, buffer->GetData()->buffer, 1u, &region);
+
+        src       += chunkSize;
+        dstOffset += chunkSize;
+        size      -= chunkSize;
+    }
+}
+
+static void LevelBarrier(VkCommandBuffer commandBuffer, Image* image, const VkImageSubresourceRange& range,
+                         VkImageLayout oldLayout, VkImageLayout newLayout,
+                         VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+                         VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess)
+{
+    VkImageMemoryBarrier2KHR imageBarrier = {};
+    imageBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+    imageBarrier.srcStageMask        = srcStage;
+    imageBarrier.srcAccessMask       = srcAccess;
+    imageBarrier.dstStageMask        = dstStage;
+    imageBarrier.dstAccessMask       = dstAccess;
+    imageBarrier.oldLayout           = oldLayout;
+    imageBarrier.newLayout           = newLayout;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.image               = image->GetData()->image;
+    imageBarrier.subresourceRange    = range;
+
+    VkDependencyInfo dependencyInfo = {};
+    dependencyInfo.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.imageMemoryBarrierCount = 1u;
+    dependencyInfo.pImageMemoryBarriers    = &imageBarrier;
+
+    Device::vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+}
+
+void StagingRing::UploadImage(Image* image, uint32_t mipLevel, uint32_t arrayLayer, VkExtent2D blockExtent,
+                              const void* srcPtr, VkDeviceSize size, VkImageLayout layout)
+{
+    auto& imageInfo = image->GetInfo()->image;
+
+    uint32_t width  = std::max(imageInfo.extent.width  >> mipLevel, 1u);
+    uint32_t height = std::max(imageInfo.extent.height >> mipLevel, 1u);
+
+    uint32_t blocksWide = (width  + blockExtent.width  - 1) / blockExtent.width;
+    uint32_t blockRows  = (height + blockExtent.height - 1) / blockExtent.height;
+
+    VkDeviceSize rowPitch   = size / blockRows;
+    VkDeviceSize blockBytes = rowPitch / blocksWide;
+
+    if (blockBytes == 0 || rowPitch * blockRows != size || blockBytes * blocksWide != rowPitch)
+        throw std::runtime_error("image upload size does not match the mip level.");
+
+    // Buffer offsets of image copies must be a multiple of the block size (and of 4).
+    VkDeviceSize alignment = (STAGING_ALIGNMENT % blockBytes == 0) ? STAGING_ALIGNMENT : STAGING_ALIGNMENT * blockBytes;
+
+    VkImageSubresourceRange range = {};
+    range.aspectMask     = image->GetInfo()->view.subresourceRange.aspectMask;
+    range.baseMipLevel   = mipLevel;
+    range.levelCount     = 1;
+    range.baseArrayLayer = arrayLayer;
+    range.layerCount     = 1;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Like buffer uploads, large levels are split (by rows of blocks) so that one call can never wait on its own copies.
+    uint32_t maxChunkRows = (uint32_t)std::max<VkDeviceSize>((m_Capacity / 2) / rowPitch, 1);
+
+    // Sourced from the transfer stage to chain after the batch's leading barrier, whose scope ends there.
+    LevelBarrier(BeginBatch().commandBuffer, image, range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                 VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    auto src = static_cast<const uint8_t*>(srcPtr);
+
+    for (uint32_t row = 0; row < blockRows;)
+    {
+        uint32_t     chunkRows = std::min(maxChunkRows, blockRows - row);
+        VkDeviceSize chunkSize = chunkRows * rowPitch;
+        VkDeviceSize offset    = Allocate(chunkSize, alignment);
+
+        memcpy(m_MappedData + offset, src, chunkSize);
+
+        uint32_t y = row * blockExtent.height;
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset                    = offset;
+        region.imageSubresource.aspectMask     = range.aspectMask;
+        region.imageSubresource.mipLevel       = mipLevel;
+        region.imageSubresource.baseArrayLayer = arrayLayer;
+        region.imageSubresource.layerCount     = 1;
+        region.imageOffset                     = { 0, (int32_t)y, 0 };
+        region.imageExtent                     = { width, std::min(chunkRows * blockExtent.height, height - y), 1 };
+
+        vkCmdCopyBufferToImage(BeginBatch().commandBuffer, m_VKBuffer, image->GetData()->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1u, &region);
+
+        src += chunkSize;
+        row += chunkRows;
+    }
+
+    LevelBarrier(BeginBatch().commandBuffer, image, range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout,
+                 VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_READ_BIT);
+
+    // Work recorded after the batch needs no further synchronization with the copy.
+    auto state = image->GetState(mipLevel, arrayLayer);
+    *state = {};
+    state->layout = layout;
+}
+
+void StagingRing::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    SubmitBatch();
+}
+
+VkDeviceSize StagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (size > m_Capacity)
+        throw std::runtime_error("staging allocation larger than the ring.");
+
+    for (;;)
+    {
+        // Align the ring offset rather than the monotonic position, with a division since image uploads
+        // align to multiples of their texel size (e.g. 48 bytes for 3-byte texels).
+        VkDeviceSize offset  = m_Head % m_Capacity;
+        VkDeviceSize aligned = ((offset + alignment - 1) / alignment) * alignment;
+
+        uint64_t head = m_Head + (aligned - offset);
+
+        // Never straddle the end of the ring, restart at the beginning instead.
+        if ((head % m_Capacity) + size > m_Capacity)
+            head += m_Capacity - (head % m_Capacity);
+
+        if (head + size - m_Tail <= m_Capacity)
+        {
+            m_Head = head + size;
+            return head % m_Capacity;
+        }
+
+        // Out of space, wait for the oldest batch still on the GPU.
+        if (RetireOldestBatch())
+            continue;
+
+        // The batch being recorded is holding the rest of the ring, so submit it and retire it.
+        if (m_Batches[m_BatchIndex].recording)
+        {
+            SubmitBatch();
+            continue;
+        }
+
+        // Nothing is in use, start over from the beginning.
+        m_Head = 0;
+        m_Tail = 0;
+    }
+}
+
+StagingRing::Batch& StagingRing::BeginBatch()
+{
+    Batch& batch = m_Batches[m_BatchIndex];
+
+    if (batch.recording)
+        return batch;
+
+    if (batch.inFlight)
+    {
+        vkWaitForFences(m_Device->GetLogical(), 1u, &batch.fence, VK_TRUE, UINT64_MAX);
+
+        m_Tail         = std::max(m_Tail, batch.end);
+        batch.inFlight = false;
+    }
+
+    vkResetFences(m_Device->GetLogical(), 1u, &batch.fence);
+    vkResetCommandBuffer(batch.commandBuffer, 0x0);
+
+    VkCommandBufferBeginInfo commandBegin = {};
+    commandBegin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    commandBegin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    vkBeginCommandBuffer(batch.commandBuffer, &commandBegin);
+
+    // Submission order isn't execution order: frames submitted earlier may still read or write the
+    // destinations, so the copies wait for them.
+    VkMemoryBarrier2KHR memoryBarrier = {};
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+    memoryBarrier.srcStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    memoryBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+    memoryBarrier.dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+    VkDependencyInfo dependencyInfo = {};
+    dependencyInfo.sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount = 1u;
+    dependencyInfo.pMemoryBarriers    = &memoryBarrier;
+
+    Device::vkCmdPipelineBarrier2KHR(batch.commandBuffer, &dependencyInfo);
+
+    batch.recording = true;
+
+    return batch;
+}
+
+bool StagingRing::RetireOldestBatch()
+{
+    Batch* oldest = nullptr;
+
+    for (auto& batch : m_Batches)
+    {
+        if (batch.inFlight && (oldest == nullptr || batch.end < oldest->end))
+            oldest = &batch;
+    }
+
+    if (oldest == nullptr)
+        return false;
+
+    vkWaitForFences(m_Device->GetLogical(), 1u, &oldest->fence, VK_TRUE, UINT64_MAX);
+
+    m_Tail           = std::max(m_Tail, oldest->end);
+    oldest->inFlight = false;
+
+    return true;
+}
+
+void StagingRing::SubmitBatch()
+{
+    Batch& batch = m_Batches[m_BatchIndex];
+
+    if (!batch.recording)
+        return;
+
+    // No-op for coherent memory.
+    vmaFlushAllocation(m_Device->GetAllocator(), m_VMAAllocation, 0, VK_WHOLE_SIZE);
+
+    // Make the copies visible to any work submitted after this batch.
+    VkMemoryBarrier2KHR memoryBarrier = {};
+    memoryBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+    memoryBarrier.srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+    memoryBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+    VkDependencyInfo dependencyInfo = {};
+    dependencyInfo.sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.memoryBarrierCount = 1u;
+    dependencyInfo.pMemoryBarriers    = &memoryBarrier;
+
+    Device::vkCmdPipelineBarrier2KHR(batch.commandBuffer, &dependencyInfo);
+
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1u;
+    submitInfo.pCommandBuffers    = &batch.commandBuffer;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Device->GetQueueMutex());
+
+        if (vkQueueSubmit(m_Device->GetGraphicsQueue(), 1u, &submitInfo, batch.fence) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit staging batch.");
+    }
+
+    batch.end       = m_Head;
+    batch.recording = false;
+    batch.inFlight  = true;
+
+    m_BatchIndex = (m_BatchIndex + 1) % NUM_FRAMES_IN_FLIGHT;
+}
@@ -0,0 +1,186 @@
+#include <VulkanWrappers/StateCache.h>
+#include <VulkanWrappers/Device.h>
+
+#include <cstring>
+
+using namespace VulkanWrappers;
+
+RenderState RenderState::Default()
+{
+    RenderState state = {};
+    state.topology                = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    state.polygonMode             = VK_POLYGON_MODE_FILL;
+    state.cullMode                = VK_CULL_MODE_BACK_BIT;
+    state.frontFace               = VK_FRONT_FACE_CLOCKWISE;
+    state.rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT;
+    state.sampleMask              = 0xFFFFFFFF;
+    state.primitiveRestartEnable  = VK_FALSE;
+    state.rasterizerDiscardEnable = VK_FALSE;
+    state.alphaToCoverageEnable   = VK_FALSE;
+    state.depthTestEnable         = VK_FALSE;
+    state.depthWriteEnable        = VK_FALSE;
+    state.depthBiasEnable         = VK_FALSE;
+    state.stencilTestEnable       = VK_FALSE;
+    state.blendEnable             = VK_FALSE;
+    state.colorWriteMask          = VK_COLOR_COMPONENT_R_BIT |
+                                    VK_COLOR_COMPONENT_G_BIT |
+                                    VK_COLOR_COMPONENT_B_BIT |
+                                    VK_COLOR_COMPONENT_A_BIT;
+
+    state.colorBlendEquation =
+    {
+        // Color
+        VK_BLEND_FACTOR_ONE,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_OP_ADD,
+
+        // Alpha
+        VK_BLEND_FACTOR_ONE,
+        VK_BLEND_FACTOR_ZERO,
+        VK_BLEND_OP_ADD,
+    };
+
+    state.viewport = { 0, 0, 64, 64, 0.0, 1.0 };
+    state.scissor  = { 0, 0, 64, 64 };
+
+    return state;
+}
+
+void StateCache::Begin(VkCommandBuffer commandBuffer)
+{
+    m_CommandBuffer = commandBuffer;
+    m_State         = RenderState::Default();
+
+    Invalidate();
+}
+
+void StateCache::Invalidate()
+{
+    m_KnownFields = 0x0;
+
+    m_Shaders.fill(VK_NULL_HANDLE);
+    m_HasShader.fill(false);
+}
+
+template <typename T>
+bool StateCache::Differs(Field field, T& current, const T& value)
+{
+    // Bitwise compare, the tracked values are plain Vulkan structs / enums without padding.
+    if ((m_KnownFields & (1u << field)) && memcmp(&current, &value, sizeof(T)) == 0)
+        return false;
+
+    current        = value;
+    m_KnownFields |= 1u << field;
+
+    return true;
+}
+
+void StateCache::SetState(const RenderState& state)
+{
+    auto commandBuffer = m_CommandBuffer;
+
+    if (Differs(BlendEnable, m_State.blendEnable, state.blendEnable))
+        Device::vkCmdSetColorBlendEnableEXT(commandBuffer, 0u, 1u, &m_State.blendEnable);
+
+    if (Differs(ColorWriteMask, m_State.colorWriteMask, state.colorWriteMask))
+        Device::vkCmdSetColorWriteMaskEXT(commandBuffer, 0u, 1u, &m_State.colorWriteMask);
+
+    if (Differs(ColorBlendEquation, m_State.colorBlendEquation, state.colorBlendEquation))
+        Device::vkCmdSetColorBlendEquationEXT(commandBuffer, 0u, 1u, &m_State.colorBlendEquation);
+
+    SetViewport(state.viewport);
+    SetScissor(state.scissor);
+
+    if (Differs(PrimitiveRestartEnable, m_State.primitiveRestartEnable, state.primitiveRestartEnable))
+        Device::vkCmdSetPrimitiveRestartEnableEXT(commandBuffer, m_State.primitiveRestartEnable);
+
+    if (Differs(RasterizerDiscardEnable, m_State.rasterizerDiscardEnable, state.rasterizerDiscardEnable))
+        Device::vkCmdSetRasterizerDiscardEnableEXT(commandBuffer, m_State.rasterizerDiscardEnable);
+
+    if (Differs(AlphaToCoverageEnable, m_State.alphaToCoverageEnable, state.alphaToCoverageEnable))
+        Device::vkCmdSetAlphaToCoverageEnableEXT(commandBuffer, m_State.alphaToCoverageEnable);
+
+    if (Differs(StencilTestEnable, m_State.stencilTestEnable, state.stencilTestEnable))
+        Device::vkCmdSetStencilTestEnableEXT(commandBuffer, m_State.stencilTestEnable);
+
+    if (Differs(DepthTestEnable, m_State.depthTestEnable, state.depthTestEnable))
+        Device::vkCmdSetDepthTestEnableEXT(commandBuffer, m_State.depthTestEnable);
+
+    if (Differs(DepthBiasEnable, m_State.depthBiasEnable, state.depthBiasEnable))
+        Device::vkCmdSetDepthBiasEnableEXT(commandBuffer, m_State.depthBiasEnable);
+
+    if (Differs(DepthWriteEnable, m_State.depthWriteEnable, state.depthWriteEnable))
+        Device::vkCmdSetDepthWriteEnableEXT(commandBuffer, m_State.depthWriteEnable);
+
+    bool samplesChanged = Differs(RasterizationSamples, m_State.rasterizationSamples, state.rasterizationSamples);
+
+    if (samplesChanged)
+        Device::vkCmdSetRasterizationSamplesEXT(commandBuffer, m_State.rasterizationSamples);
+
+    // The mask is sized by the sample count, so it follows it.
+    if (Differs(SampleMask, m_State.sampleMask, state.sampleMask) || samplesChanged)
+        Device::vkCmdSetSampleMaskEXT(commandBuffer, m_State.rasterizationSamples, &m_State.sampleMask);
+
+    if (Differs(FrontFace, m_State.frontFace, state.frontFace))
+        Device::vkCmdSetFrontFaceEXT(commandBuffer, m_State.frontFace);
+
+    if (Differs(PolygonMode, m_State.polygonMode, state.polygonMode))
+        Device::vkCmdSetPolygonModeEXT(commandBuffer, m_State.polygonMode);
+
+    if (Differs(CullMode, m_State.cullMode, state.cullMode))
+        Device::vkCmdSetCullModeEXT(commandBuffer, m_State.cullMode);
+
+    if (Differs(Topology, m_State.topology, state.topology))
+        Device::vkCmdSetPrimitiveTopologyEXT(commandBuffer, m_State.topology);
+}
+
+void StateCache::SetViewport(const VkViewport& viewport)
+{
+    if (Differs(Viewport, m_State.viewport, viewport))
+        Device::vkCmdSetViewportWithCountEXT(m_CommandBuffer, 1u, &m_State.viewport);
+}
+
+void StateCache::SetScissor(const VkRect2D& scissor)
+{
+    if (Differs(Scissor, m_State.scissor, scissor))
+        Device::vkCmdSetScissorWithCountEXT(m_CommandBuffer, 1u, &m_State.scissor);
+}
+
+uint32_t StateCache::GetStageSlot(VkShaderStageFlagBits stage)
+{
+    switch (stage)
+    {
+        case VK_SHADER_STAGE_VERTEX_BIT:                  return 0u;
+        case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:    return 1u;
+        case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: return 2u;
+        case VK_SHADER_STAGE_GEOMETRY_BIT:                return 3u;
+        case VK_SHADER_STAGE_FRAGMENT_BIT:                return 4u;
+        case VK_SHADER_STAGE_COMPUTE_BIT:                 return 5u;
+        case VK_SHADER_STAGE_TASK_BIT_EXT:                return 6u;
+        case VK_SHADER_STAGE_MESH_BIT_EXT:                return 7u;
+        default: throw std::runtime_error("unsupported shader stage.");
+    }
+}
+
+void StateCache::BindShaders(uint32_t stageCount, const VkShaderStageFlagBits* stages, const VkShaderEXT* shaders)
+{
+    m_BindStages.clear();
+    m_BindShaders.clear();
+
+    for (uint32_t i = 0; i < stageCount; ++i)
+    {
+        auto slot = GetStageSlot(stages[i]);
+
+        if (m_HasShader[slot] && m_Shaders[slot] == shaders[i])
+            continue;
+
+        m_HasShader[slot] = true;
+        m_Shaders[slot]   = shaders[i];
+
+        m_BindStages.push_back(stages[i]);
+        m_BindShaders.push_back(shaders[i]);
+    }
+
+    if (!m_BindStages.empty())
+        Device::vkCmdBindShadersEXT(m_CommandBuffer, (uint32_t)m_BindStages.size(), m_BindStages.data(), m_BindShaders.data());
+}
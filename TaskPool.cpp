@@ -0,0 +1,90 @@
+#include <VulkanWrappers/TaskPool.h>
+
+using namespace VulkanWrappers;
+
+TaskPool::TaskPool(uint32_t threadCount)
+    : m_Task(nullptr), m_TaskCount(0), m_NextTask(0), m_ActiveWorkers(0), m_Generation(0), m_Exit(false)
+{
+    for (uint32_t i = 1; i < threadCount; ++i)
+        m_Workers.emplace_back(&TaskPool::WorkerLoop, this);
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Exit = true;
+    }
+
+    m_WakeCondition.notify_all();
+
+    for (auto& worker : m_Workers)
+        worker.join();
+}
+
+void TaskPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+{
+    if (count == 0)
+        return;
+
+    std::lock_guard<std::mutex> jobLock(m_JobMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Task          = &task;
+        m_TaskCount     = count;
+        m_ActiveWorkers = (uint32_t)m_Workers.size();
+        m_NextTask.store(0);
+
+        ++m_Generation;
+    }
+
+    m_WakeCondition.notify_all();
+
+    // Help out instead of idling.
+    RunTasks(task, count);
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_DoneCondition.wait(lock, [this] { return m_ActiveWorkers == 0; });
+
+    m_Task = nullptr;
+}
+
+void TaskPool::RunTasks(const std::function<void(uint32_t)>& task, uint32_t count)
+{
+    for (uint32_t i = m_NextTask.fetch_add(1); i < count; i = m_NextTask.fetch_add(1))
+        task(i);
+}
+
+void TaskPool::WorkerLoop()
+{
+    uint64_t generation = 0;
+
+    for (;;)
+    {
+        const std::function<void(uint32_t)>* task;
+        uint32_t                             count;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeCondition.wait(lock, [&] { return m_Exit || m_Generation != generation; });
+
+            if (m_Exit)
+                return;
+
+            generation = m_Generation;
+            task       = m_Task;
+            count      = m_TaskCount;
+        }
+
+        RunTasks(*task, count);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            if (--m_ActiveWorkers == 0)
+                m_DoneCondition.notify_one();
+        }
+    }
+}
@@ -0,0 +1,241 @@
+#include <VulkanWrappers/TextureStreamer.h>
+#include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/StagingRing.h>
+
+#include <algorithm>
+#include <string.h>
+
+using namespace VulkanWrappers;
+
+// KTX2 File Layout
+// ----------------------------------------
+
+struct KTX2Header
+{
+    uint8_t  identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+
+    // Index
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct KTX2Level
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+static_assert(sizeof(KTX2Header) == 80, "KTX2Header must match the file layout.");
+static_assert(sizeof(KTX2Level)  == 24, "KTX2Level must match the file layout.");
+
+static const uint8_t s_KTX2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+static VkExtent2D GetBlockExtent(VkFormat format)
+{
+    // BC1 - BC7, ETC2 and EAC.
+    if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK)
+        return { 4, 4 };
+
+    // ASTC, in UNORM / SRGB pairs.
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+    {
+        static const VkExtent2D s_ASTCExtents[] =
+        {
+            { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+            { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 }
+        };
+
+        return s_ASTCExtents[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+    }
+
+    return { 1, 1 };
+}
+
+// Streamer
+// ----------------------------------------
+
+TextureStreamer::TextureStreamer(Device* device) : m_Device(device) {}
+
+TextureStreamer::~TextureStreamer()
+{
+    std::vector<Image*> images;
+
+    for (auto& texture : m_Textures)
+        images.push_back(&texture.m_Image);
+
+    m_Device->ReleaseImages(images);
+}
+
+TextureStreamer::Texture* TextureStreamer::Load(const char* filePath)
+{
+    m_Textures.emplace_back();
+
+    auto& texture = m_Textures.back();
+
+    try
+    {
+        if (!texture.m_File.Open(filePath))
+            throw std::runtime_error("failed to map texture file.");
+
+        auto fileData = static_cast<const uint8_t*>(texture.m_File.GetData());
+        auto fileSize = texture.m_File.GetSize();
+
+        KTX2Header header = {};
+
+        if (fileSize < sizeof(KTX2Header))
+            throw std::runtime_error("texture file is too small for a KTX2 header.");
+
+        memcpy(&header, fileData, sizeof(KTX2Header));
+
+        if (memcmp(header.identifier, s_KTX2Identifier, sizeof(s_KTX2Identifier)) != 0)
+            throw std::runtime_error("texture file is not KTX2.");
+
+        // Basis Universal (no format) and supercompressed payloads need transcoding first.
+        if (header.vkFormat == VK_FORMAT_UNDEFINED || header.supercompressionScheme != 0)
+            throw std::runtime_error("supercompressed KTX2 textures are not supported.");
+
+        if (header.pixelDepth > 1 || header.pixelHeight == 0 || (header.faceCount != 1 && header.faceCount != 6))
+            throw std::runtime_error("only 2D and cube KTX2 textures are supported.");
+
+        auto format = (VkFormat)header.vkFormat;
+
+        VkFormatProperties formatProperties = {};
+        vkGetPhysicalDeviceFormatProperties(m_Device->GetPhysical(), format, &formatProperties);
+
+        if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+            throw std::runtime_error("texture format is not supported by the device.");
+
+        // A level count of 0 asks for generated mips, only the base level is stored.
+        texture.m_LevelCount    = std::max(header.levelCount, 1u);
+        texture.m_LayerCount    = std::max(header.layerCount, 1u) * header.faceCount;
+        texture.m_BlockExtent   = GetBlockExtent(format);
+        texture.m_ResidentLevel = texture.m_LevelCount;
+
+        if (fileSize < sizeof(KTX2Header) + sizeof(KTX2Level) * texture.m_LevelCount)
+            throw std::runtime_error("texture file is too small for its level index.");
+
+        for (uint32_t i = 0; i < texture.m_LevelCount; ++i)
+        {
+            KTX2Level level = {};
+            memcpy(&level, fileData + sizeof(KTX2Header) + sizeof(KTX2Level) * i, sizeof(KTX2Level));
+
+            if (level.byteOffset + level.byteLength > fileSize || level.byteLength % texture.m_LayerCount != 0)
+                throw std::runtime_error("texture file has an invalid level.");
+
+            texture.m_Levels.push_back({ level.byteOffset, level.byteLength });
+        }
+
+        texture.m_Image = Image(header.pixelWidth, header.pixelHeight, format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                VK_IMAGE_ASPECT_COLOR_BIT, texture.m_LevelCount, texture.m_LayerCount);
+
+        auto info = texture.m_Image.GetInfo();
+
+        if (header.faceCount == 6)
+        {
+            info->image.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+            info->view.viewType = texture.m_LayerCount > 6 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        }
+
+        // Nothing is resident yet, start with the coarsest level in the view.
+        info->view.subresourceRange.baseMipLevel = texture.m_LevelCount - 1;
+        info->view.subresourceRange.levelCount   = 1;
+
+        m_Device->CreateImages({ &texture.m_Image });
+    }
+    catch (...)
+    {
+        m_Textures.pop_back();
+        throw;
+    }
+
+    m_Pending.push_back(&texture);
+
+    return &texture;
+}
+
+void TextureStreamer::Update(VkDeviceSize byteBudget)
+{
+    m_Updated.clear();
+    m_UpdatedImages.clear();
+
+    VkDeviceSize uploaded = 0;
+    bool         progress = true;
+
+    // One level per texture per round, so every texture gets its coarse levels before any gets its finest.
+    while (progress && (uploaded < byteBudget || uploaded == 0))
+    {
+        progress = false;
+
+        for (auto texture : m_Pending)
+        {
+            if (texture->IsResident() || (uploaded >= byteBudget && uploaded > 0))
+                continue;
+
+            uint32_t level     = texture->m_ResidentLevel - 1;
+            auto&    levelData = texture->m_Levels[level];
+
+            auto         src       = static_cast<const uint8_t*>(texture->m_File.GetData()) + levelData.offset;
+            VkDeviceSize layerSize = levelData.size / texture->m_LayerCount;
+
+            for (uint32_t layer = 0; layer < texture->m_LayerCount; ++layer)
+            {
+                m_Device->GetStagingRing()->UploadImage(&texture->m_Image, level, layer, texture->m_BlockExtent,
+                                                        src + layerSize * layer, layerSize, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+
+            if (std::find(m_Updated.begin(), m_Updated.end(), texture) == m_Updated.end())
+                m_Updated.push_back(texture);
+
+            texture->m_ResidentLevel = level;
+
+            uploaded += levelData.size;
+            progress  = true;
+        }
+    }
+
+    if (m_Updated.empty())
+        return;
+
+    // The copies are submitted ahead of the frame being recorded, so it can already sample the new levels.
+    m_Device->FlushUploads();
+
+    for (auto texture : m_Updated)
+    {
+        auto& range = texture->m_Image.GetInfo()->view.subresourceRange;
+        range.baseMipLevel = texture->m_ResidentLevel;
+        range.levelCount   = texture->m_LevelCount - texture->m_ResidentLevel;
+
+        m_UpdatedImages.push_back(&texture->m_Image);
+
+        // The file is no longer needed once every level is on the GPU.
+        if (texture->IsResident())
+            texture->m_File.Release();
+    }
+
+    m_Device->UpdateImageViews(m_UpdatedImages);
+
+    m_Pending.erase(std::remove_if(m_Pending.begin(), m_Pending.end(), [](Texture* texture) { return texture->IsResident(); }), m_Pending.end());
+}
+
+void TextureStreamer::Release(Texture* texture)
+{
+    m_Pending.erase(std::remove(m_Pending.begin(), m_Pending.end(), texture), m_Pending.end());
+
+    m_Device->ReleaseImages({ &texture->m_Image });
+
+    m_Textures.remove_if([&](const Texture& other) { return &other == texture; });
+}
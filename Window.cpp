@@ -1,5 +1,8 @@
 #include <VulkanWrappers/Window.h>
 #include <VulkanWrappers/Device.h>
+#include <VulkanWrappers/GpuProfiler.h>
+#include <VulkanWrappers/CpuTrace.h>
+#include <VulkanWrappers/FrameCommandPools.h>
 
 #include "algorithm"
 #if __APPLE__
@@ -8,9 +11,6 @@
     
     // Objective-C wrapper to bind a KHR surface to native macOS window. 
     #include "MetalUtility.h"
-#else
-    #define GLFW_EXPOSE_NATIVE_WIN32
-    #include <vulkan/vulkan_win32.h>
 #endif
 
 #include <GLFW/glfw3.h>
@@ -94,7 +94,7 @@ VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR* capabilities, GLFWwi
 }
 
 Window::Window(const char* name, uint32_t width, uint32_t height)
-    : m_Width(width), m_Height(height), m_FrameCount(0), m_FrameIndex(0)
+    : m_Width(width), m_Height(height), m_FrameIndex(0)
 {
     glfwInit();
 
@@ -141,24 +141,8 @@ void Window::CreateVulkanSurface(const Device* device)
             throw std::runtime_error("failed to create surface.");
     }
 #else
-	VkWin32SurfaceCreateInfoKHR createInfo = {};
-    createInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-    createInfo.pNext = nullptr;
-    createInfo.flags = 0;
-    createInfo.hwnd = glfwGetWin32Window(m_GLFWWindow);
-    // .pView = (m_GLFWWindow)
-        
-    PFN_vkCreateWin32SurfaceKHR vkCreateWin32SurfaceKHR;
-    
-    vkCreateWin32SurfaceKHR = (PFN_vkCreateWin32SurfaceKHR )vkGetInstanceProcAddr(device->GetInstance(), "vkCreateWin32SurfaceKHR");
-
-    if (!vkCreateWin32SurfaceKHR) 
-    {
-        // Note: This call will fail unless we add VK_MVK_MACOS_SURFACE_EXTENSION_NAME extension. 
-        throw std::runtime_error("Unabled to get pointer to function: VkWin32SurfaceCreateInfoKHR");
-    }
-
-    if (vkCreateWin32SurfaceKHR(device->GetInstance(), &createInfo, nullptr, &m_VKSurface)!= VK_SUCCESS) 
+    // Windows, X11 and Wayland: GLFW picks the platform's surface extension (listed by glfwGetRequiredInstanceExtensions).
+    if (glfwCreateWindowSurface(device->GetInstance(), m_GLFWWindow, nullptr, &m_VKSurface) != VK_SUCCESS)
         throw std::runtime_error("failed to create surface.");
 #endif
 
@@ -200,6 +184,16 @@ void Window::CreateVulkanSwapchain(const Device* device)
     createInfo.queueFamilyIndexCount = 0;
     createInfo.pQueueFamilyIndices   = NULL;
 
+    // Separate graphics and present families share the images instead of transferring ownership every frame.
+    uint32_t queueFamilyIndices[] = { device->GetGraphicsQueueFamily(), device->GetPresentQueueFamily() };
+
+    if (queueFamilyIndices[0] != queueFamilyIndices[1])
+    {
+        createInfo.imageSharingMode      = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = 2u;
+        createInfo.pQueueFamilyIndices   = queueFamilyIndices;
+    }
+
     if(vkCreateSwapchainKHR(device->GetLogical(), &createInfo, NULL, &m_VKSwapchain) != VK_SUCCESS)
         throw std::runtime_error("failed to create swap chain.");
 
@@ -250,42 +244,41 @@ void Window::CreateVulkanSwapchain(const Device* device)
 
         vkCreateSemaphore(device->GetLogical(), &binarySemaphoreInfo, nullptr, &m_GraphicsQueueCompleteSemaphores[i]);
         vkCreateSemaphore(device->GetLogical(), &binarySemaphoreInfo, nullptr, &m_ImageAcquireSemaphores[i]);
-
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceInfo .flags = VK_FENCE_CREATE_SIGNALED_BIT;
-        fenceInfo.pNext = nullptr;
-
-        vkCreateFence(device->GetLogical(), &fenceInfo, nullptr, &m_GraphicsQueueCompleteFences[i]);
-
-        // Command buffer.
-        device->CreateCommandBuffer(&m_VKCommandBuffers[i]);
     }
 }
 
-bool Window::NextFrame(const Device* device, Frame* frame)
+bool Window::NextFrame(Device* device, Frame* frame)
 {
+    CPU_TRACE_SCOPE("Window::NextFrame");
+
     if (glfwWindowShouldClose(m_GLFWWindow))
         return false;
 
     glfwPollEvents();
 
-    // Pause thread until graphics queue finished processing. 
-    vkWaitForFences(device->GetLogical(), 1u, &m_GraphicsQueueCompleteFences[m_FrameIndex], VK_TRUE, UINT64_MAX);
+    // The number is fixed here, so the profiler and callers waiting on frame.number see the value SubmitFrame signals.
+    uint64_t frameNumber = device->AcquireFrameNumber();
 
-    // Reset the fence for this frame.
-    vkResetFences(device->GetLogical(), 1u, &m_GraphicsQueueCompleteFences[m_FrameIndex]);
+    // Pause thread until the graphics queue retired the last frame that used this slot. 
+    if (frameNumber > NUM_FRAMES_IN_FLIGHT)
+        device->WaitForFrame(frameNumber - NUM_FRAMES_IN_FLIGHT);
 
     // Grab the next image in the swap chain and signal the current semaphore when it can be drawn to. 
-    vkAcquireNextImageKHR(device->GetLogical(), m_VKSwapchain, UINT64_MAX, m_ImageAcquireSemaphores[m_FrameIndex], VK_NULL_HANDLE, &m_VKSwapchainImageIndex);
+    {
+        CPU_TRACE_SCOPE("vkAcquireNextImageKHR");
+        vkAcquireNextImageKHR(device->GetLogical(), m_VKSwapchain, UINT64_MAX, m_ImageAcquireSemaphores[m_FrameIndex], VK_NULL_HANDLE, &m_VKSwapchainImageIndex);
+    }
+
+    // The GPU is done with this frame slot, recycle its command pools and other per-frame state.
+    device->BeginFrame(m_FrameIndex);
 
     *frame = m_Frames[m_VKSwapchainImageIndex];
+    frame->index  = m_FrameIndex;
+    frame->number = frameNumber;
     
     // Attach the command buffer for this frame
-    frame->commandBuffer = m_VKCommandBuffers[m_FrameIndex];
-
-    // Reset the command buffer for this frame.
-    vkResetCommandBuffer(frame->commandBuffer, 0x0);
+    frame->commandBuffer = device->GetFrameCommandPools()->Allocate(m_FrameIndex);
+    frame->stateCache.Begin(frame->commandBuffer);
 
     // Enable the command buffer into a recording state. 
     VkCommandBufferBeginInfo commandBegin = {};
@@ -295,33 +288,63 @@ bool Window::NextFrame(const Device* device, Frame* frame)
 
     vkBeginCommandBuffer(frame->commandBuffer, &commandBegin);
 
+    if (device->GetGpuProfiler() != nullptr)
+        device->GetGpuProfiler()->BeginFrame(frame);
+
     return true;
 }
 
 void Window::SubmitFrame(Device* device, const Frame* frame)
 {
+    CPU_TRACE_SCOPE("Window::SubmitFrame");
+
+    if (device->GetGpuProfiler() != nullptr)
+        device->GetGpuProfiler()->EndFrame(frame);
+
     // Conclude command buffer recording.
     vkEndCommandBuffer(frame->commandBuffer);
 
+    // Any uploads made during the frame land on the queue ahead of it.
+    device->FlushUploads();
+
     VkPipelineStageFlags backBufferWaitStage[] = 
     {
         // Backbuffer can be written to once it is in this stage. 
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
     };
 
+    // Primaries recorded by other threads run ahead of the frame's own command buffer.
+    m_SubmitCommandBuffers.clear();
+    device->GetFrameCommandPools()->TakeQueued(m_FrameIndex, &m_SubmitCommandBuffers);
+    m_SubmitCommandBuffers.push_back(frame->commandBuffer);
+
+    // Signal presentation and the frame's number on the timeline (the value is ignored for the binary semaphore).
+    VkSemaphore signalSemaphores[] = { m_GraphicsQueueCompleteSemaphores[m_FrameIndex], device->GetFrameTimeline() };
+    uint64_t    signalValues[]     = { 0u, frame->number };
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 2u;
+    timelineInfo.pSignalSemaphoreValues    = signalValues;
+
     VkSubmitInfo submitInfo = {};
 
     submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount   = 1u;
-    submitInfo.pCommandBuffers      = &frame->commandBuffer;
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.commandBufferCount   = (uint32_t)m_SubmitCommandBuffers.size();
+    submitInfo.pCommandBuffers      = m_SubmitCommandBuffers.data();
     submitInfo.waitSemaphoreCount   = 1u;
     submitInfo.pWaitSemaphores      = &m_ImageAcquireSemaphores[m_FrameIndex];
     submitInfo.pWaitDstStageMask    = backBufferWaitStage;
-    submitInfo.signalSemaphoreCount = 1u;
-    submitInfo.pSignalSemaphores    = &m_GraphicsQueueCompleteSemaphores[m_FrameIndex];
+    submitInfo.signalSemaphoreCount = 2u;
+    submitInfo.pSignalSemaphores    = signalSemaphores;
 
-    // Submit the graphics queue and signal both the presentation semaphore and the next frame's fence when done. 
-    vkQueueSubmit(device->GetGraphicsQueue(), 1u, &submitInfo, m_GraphicsQueueCompleteFences[m_FrameIndex]);
+    // Submit the graphics queue and signal both the presentation semaphore and the frame timeline when done. 
+    {
+        CPU_TRACE_SCOPE("vkQueueSubmit");
+        std::lock_guard<std::mutex> lock(device->GetQueueMutex());
+        vkQueueSubmit(device->GetGraphicsQueue(), 1u, &submitInfo, VK_NULL_HANDLE);
+    }
 
     // Present.
 
@@ -334,7 +357,11 @@ void Window::SubmitFrame(Device* device, const Frame* frame)
     presentInfo.waitSemaphoreCount = 1u;
     presentInfo.pWaitSemaphores    = &m_GraphicsQueueCompleteSemaphores[m_FrameIndex];
 
-    vkQueuePresentKHR(device->GetPresentQueue(), &presentInfo);
+    {
+        CPU_TRACE_SCOPE("vkQueuePresentKHR");
+        std::lock_guard<std::mutex> lock(device->GetQueueMutex());
+        vkQueuePresentKHR(device->GetPresentQueue(), &presentInfo);
+    }
 
     // Compute next frame Index.
     m_FrameIndex = (m_FrameIndex + 1) % NUM_FRAMES_IN_FLIGHT;
@@ -345,9 +372,6 @@ void Window::ReleaseVulkanObjects(const Device* device)
     for (auto& frame : m_Frames)
         vkDestroyImageView(device->GetLogical(), frame.backBufferView, nullptr);
 
-    for (auto& fence : m_GraphicsQueueCompleteFences)
-        vkDestroyFence(device->GetLogical(), fence, nullptr);
-
     for (auto& semaphore : m_GraphicsQueueCompleteSemaphores)
         vkDestroySemaphore(device->GetLogical(), semaphore, nullptr);
 